@@ -0,0 +1,780 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "time.h"
+#include "unistd.h"
+
+#include <daggle/daggle.h>
+
+// Runs synthetic graphs of different shapes on executors with a growing
+// number of threads, and reports the throughput, the scheduling overhead, the
+// makespan compared to the ideal one and the speedup over the first thread
+// count.
+// The results are written as JSON to stderr or the output file, the logs of
+// the library go to stdout.
+//
+// Usage: daggle_bench [--nodes N] [--threads 1,2,4] [--repeat N]
+//                     [--spin-ns NS] [--shapes chain,fan,...] [--output PATH]
+
+#define PLUGIN_ROOT_PATH "plugins/"
+#define CORE_PATH PLUGIN_ROOT_PATH "/core/plugin/core.daggle"
+#define GRAPH_PATH PLUGIN_ROOT_PATH "/graph/graph.daggle"
+
+#define MAX_THREAD_COUNTS 16
+
+// Length of the chain in the subgraph of every invoker of the nested shape.
+#define NESTED_CHAIN_LENGTH 8
+
+typedef enum {
+	SHAPE_CHAIN,
+	SHAPE_FAN,
+	SHAPE_DIAMOND,
+	SHAPE_LAYERED,
+	SHAPE_NESTED,
+	NUM_SHAPES
+} shape_t;
+
+const char* shape_names[NUM_SHAPES]
+	= { "chain", "fan", "diamond", "layered", "nested" };
+
+typedef enum {
+	KIND_TRIVIAL,
+	KIND_SPIN,
+	NUM_KINDS
+} kind_t;
+
+const char* kind_names[NUM_KINDS] = { "trivial", "spin" };
+const char* kind_node_types[NUM_KINDS] = { "bench_trivial", "bench_spin" };
+
+typedef struct options_s {
+	uint64_t num_nodes;
+	uint64_t thread_counts[MAX_THREAD_COUNTS];
+	uint64_t num_thread_counts;
+	uint64_t num_repeats;
+	uint64_t spin_ns;
+	bool shapes[NUM_SHAPES];
+	const char* output_path;
+} options_t;
+
+// Nodes doing work and the longest path through them, to compute the ideal
+// makespan from.
+typedef struct shape_info_s {
+	uint64_t num_work_nodes;
+	uint64_t depth;
+} shape_info_t;
+
+typedef struct result_s {
+	uint64_t makespan_ns;
+	uint64_t makespan_min_ns;
+	uint64_t ideal_ns;
+	uint64_t num_tasks;
+	uint64_t busy_ns;
+} result_t;
+
+// Iterations of the spin loop of the CPU-bound nodes, calibrated at startup.
+uint64_t spin_iterations = 0;
+
+// Measured duration of the spin loop.
+uint64_t spin_work_ns = 0;
+
+uint64_t
+now_ns(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+}
+
+uint64_t
+spin(uint64_t iterations, uint64_t seed)
+{
+	uint64_t x = seed | 1;
+	for (uint64_t i = 0; i < iterations; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+	}
+
+	return x;
+}
+
+// Find the iterations taking about the requested time.
+void
+calibrate_spin(uint64_t target_ns)
+{
+	uint64_t iterations = 1 << 16;
+	uint64_t elapsed = 0;
+
+	volatile uint64_t sink = 0;
+	while (elapsed < 10000000) {
+		iterations *= 2;
+
+		uint64_t start = now_ns();
+		sink += spin(iterations, sink);
+		elapsed = now_ns() - start;
+	}
+
+	spin_iterations = (uint64_t)((double)iterations * target_ns / elapsed);
+
+	uint64_t start = now_ns();
+	for (int i = 0; i < 100; ++i) {
+		sink += spin(spin_iterations, sink);
+	}
+	spin_work_ns = (now_ns() - start) / 100;
+}
+
+bool
+zero_default_value(void** out_data, const char** out_type)
+{
+	int32_t* data = malloc(sizeof *data);
+	*data = 0;
+	*out_data = data;
+	*out_type = "int";
+	return true;
+}
+
+// Add up the inputs, declared when the graph is built, into the output. The
+// sums of deep graphs overflow, so they wrap around as unsigned.
+uint32_t
+sum_inputs(daggle_node_h node)
+{
+	uint32_t sum = 0;
+
+	daggle_port_h port;
+	for (uint64_t i = 0;; ++i) {
+		daggle_node_get_port_by_index(node, i, &port);
+		if (!port) {
+			break;
+		}
+
+		daggle_port_variant_t variant;
+		daggle_port_get_variant(port, &variant);
+		if (variant != DAGGLE_PORT_INPUT) {
+			continue;
+		}
+
+		int32_t* value = NULL;
+		daggle_port_get_value(port, (void**)&value);
+		if (value) {
+			sum += (uint32_t)*value;
+		}
+	}
+
+	return sum;
+}
+
+void
+write_output(daggle_node_h node, uint32_t value)
+{
+	daggle_port_h out;
+	daggle_node_get_port_by_name(node, "out", &out);
+
+	int32_t* data = malloc(sizeof *data);
+	*data = (int32_t)value;
+	daggle_port_set_value(out, "int", data);
+}
+
+void
+bench_trivial_task(daggle_task_h task, void* context)
+{
+	write_output(context, sum_inputs(context) + 1);
+}
+
+void
+bench_spin_task(daggle_task_h task, void* context)
+{
+	uint32_t sum = sum_inputs(context);
+	write_output(context, sum + (uint32_t)(spin(spin_iterations, sum) & 1));
+}
+
+void
+bench_trivial(daggle_node_h handle)
+{
+	daggle_node_declare_output(handle, "out", NULL);
+	daggle_node_declare_task(handle, bench_trivial_task);
+}
+
+void
+bench_spin(daggle_node_h handle)
+{
+	daggle_node_declare_output(handle, "out", NULL);
+	daggle_node_declare_task(handle, bench_spin_task);
+}
+
+void
+connect_output(daggle_node_h from, const char* from_port, daggle_node_h to,
+	const char* to_port)
+{
+	daggle_port_h out;
+	daggle_port_h in;
+	daggle_node_get_port_by_name(from, from_port, &out);
+	daggle_node_get_port_by_name(to, to_port, &in);
+	daggle_port_connect(out, in);
+}
+
+daggle_node_h
+add_node(daggle_graph_h graph, kind_t kind, uint64_t num_inputs)
+{
+	daggle_node_h node;
+	daggle_graph_add_node(graph, kind_node_types[kind], &node);
+
+	for (uint64_t i = 0; i < num_inputs; ++i) {
+		char name[32];
+		snprintf(name, sizeof name, "in%llu", (unsigned long long)i);
+
+		daggle_node_declare_input(node, name, DAGGLE_INPUT_BEHAVIOR_REFERENCE,
+			zero_default_value, NULL);
+	}
+
+	return node;
+}
+
+void
+connect_input(daggle_node_h from, daggle_node_h to, uint64_t input)
+{
+	char name[32];
+	snprintf(name, sizeof name, "in%llu", (unsigned long long)input);
+
+	connect_output(from, "out", to, name);
+}
+
+shape_info_t
+build_chain(daggle_graph_h graph, kind_t kind, uint64_t num_nodes)
+{
+	daggle_node_h previous = add_node(graph, kind, 0);
+
+	for (uint64_t i = 1; i < num_nodes; ++i) {
+		daggle_node_h node = add_node(graph, kind, 1);
+		connect_input(previous, node, 0);
+
+		previous = node;
+	}
+
+	return (shape_info_t) { num_nodes, num_nodes };
+}
+
+// One source fanning out to every other node, which fan in to one sink.
+shape_info_t
+build_fan(daggle_graph_h graph, kind_t kind, uint64_t num_nodes)
+{
+	uint64_t width = num_nodes > 3 ? num_nodes - 2 : 1;
+
+	daggle_node_h source = add_node(graph, kind, 0);
+	daggle_node_h sink = add_node(graph, kind, width);
+
+	for (uint64_t i = 0; i < width; ++i) {
+		daggle_node_h node = add_node(graph, kind, 1);
+
+		connect_input(source, node, 0);
+		connect_input(node, sink, i);
+	}
+
+	return (shape_info_t) { width + 2, 3 };
+}
+
+// A chain of diamonds, each splitting into two nodes which join again.
+shape_info_t
+build_diamond(daggle_graph_h graph, kind_t kind, uint64_t num_nodes)
+{
+	uint64_t num_diamonds = num_nodes > 4 ? (num_nodes - 1) / 3 : 1;
+
+	daggle_node_h top = add_node(graph, kind, 0);
+
+	for (uint64_t i = 0; i < num_diamonds; ++i) {
+		daggle_node_h left = add_node(graph, kind, 1);
+		daggle_node_h right = add_node(graph, kind, 1);
+		daggle_node_h bottom = add_node(graph, kind, 2);
+
+		connect_input(top, left, 0);
+		connect_input(top, right, 0);
+		connect_input(left, bottom, 0);
+		connect_input(right, bottom, 1);
+
+		top = bottom;
+	}
+
+	return (shape_info_t) { 1 + num_diamonds * 3, 1 + num_diamonds * 2 };
+}
+
+// Square-ish layers, every node depending on two random nodes of the layer
+// before it.
+shape_info_t
+build_layered(daggle_graph_h graph, kind_t kind, uint64_t num_nodes)
+{
+	uint64_t width = 1;
+	while ((width + 1) * (width + 1) <= num_nodes) {
+		++width;
+	}
+
+	uint64_t num_layers = num_nodes / width;
+
+	daggle_node_h* previous = malloc(sizeof(daggle_node_h) * width);
+	daggle_node_h* current = malloc(sizeof(daggle_node_h) * width);
+
+	// Same graph on every run.
+	uint64_t seed = 0x9e3779b97f4a7c15ull;
+
+	for (uint64_t layer = 0; layer < num_layers; ++layer) {
+		for (uint64_t i = 0; i < width; ++i) {
+			current[i] = add_node(graph, kind, layer == 0 ? 0 : 2);
+
+			if (layer == 0) {
+				continue;
+			}
+
+			for (uint64_t j = 0; j < 2; ++j) {
+				seed ^= seed << 13;
+				seed ^= seed >> 7;
+				seed ^= seed << 17;
+
+				connect_input(previous[seed % width], current[i], j);
+			}
+		}
+
+		daggle_node_h* swap = previous;
+		previous = current;
+		current = swap;
+	}
+
+	free(previous);
+	free(current);
+
+	return (shape_info_t) { num_layers * width, num_layers };
+}
+
+// Serialized chain between an input and an output bridge, run by invokers.
+void
+build_nested_subgraph(daggle_instance_h instance, kind_t kind,
+	unsigned char** out_bin)
+{
+	daggle_graph_h graph;
+	daggle_graph_create(instance, &graph);
+
+	daggle_node_h input;
+	daggle_node_h output;
+	daggle_graph_add_node(graph, "input_bridge", &input);
+	daggle_graph_add_node(graph, "output_bridge", &output);
+
+	daggle_port_h input_name;
+	daggle_port_h output_name;
+	daggle_node_get_port_by_name(input, "name", &input_name);
+	daggle_node_get_port_by_name(output, "name", &output_name);
+	daggle_port_set_value(input_name, "string", strdup("bridged_input"));
+	daggle_port_set_value(output_name, "string", strdup("bridged_output"));
+
+	daggle_node_h previous = input;
+	const char* previous_port = "value";
+
+	for (uint64_t i = 0; i < NESTED_CHAIN_LENGTH; ++i) {
+		daggle_node_h node = add_node(graph, kind, 1);
+		connect_output(previous, previous_port, node, "in0");
+
+		previous = node;
+		previous_port = "out";
+	}
+
+	connect_output(previous, previous_port, output, "value");
+
+	uint64_t len;
+	daggle_graph_serialize(graph, out_bin, &len);
+	daggle_graph_free(graph);
+}
+
+// A source feeding invokers of chains, which feed a sink.
+shape_info_t
+build_nested(daggle_graph_h graph, kind_t kind, uint64_t num_nodes)
+{
+	daggle_instance_h instance;
+	daggle_graph_get_daggle(graph, &instance);
+
+	uint64_t num_invokers = num_nodes > NESTED_CHAIN_LENGTH + 2
+		? (num_nodes - 2) / NESTED_CHAIN_LENGTH
+		: 1;
+
+	unsigned char* bin;
+	build_nested_subgraph(instance, kind, &bin);
+
+	daggle_node_h source = add_node(graph, kind, 0);
+	daggle_node_h sink = add_node(graph, kind, num_invokers);
+
+	for (uint64_t i = 0; i < num_invokers; ++i) {
+		daggle_node_h invoker;
+		daggle_graph_add_node(graph, "graph_invoker", &invoker);
+
+		daggle_graph_h subgraph;
+		daggle_graph_deserialize(instance, bin, &subgraph);
+
+		daggle_port_h graph_port;
+		daggle_node_get_port_by_name(invoker, "graph", &graph_port);
+		daggle_port_set_value(graph_port, "graph_object", subgraph);
+
+		connect_output(source, "out", invoker, "bridged_input");
+
+		char name[32];
+		snprintf(name, sizeof name, "in%llu", (unsigned long long)i);
+		connect_output(invoker, "bridged_output", sink, name);
+	}
+
+	free(bin);
+
+	return (shape_info_t) { num_invokers * NESTED_CHAIN_LENGTH + 2,
+		NESTED_CHAIN_LENGTH + 2 };
+}
+
+shape_info_t
+build_graph(daggle_graph_h graph, shape_t shape, kind_t kind,
+	uint64_t num_nodes)
+{
+	switch (shape) {
+	case SHAPE_CHAIN:
+		return build_chain(graph, kind, num_nodes);
+	case SHAPE_FAN:
+		return build_fan(graph, kind, num_nodes);
+	case SHAPE_DIAMOND:
+		return build_diamond(graph, kind, num_nodes);
+	case SHAPE_LAYERED:
+		return build_layered(graph, kind, num_nodes);
+	default:
+	case SHAPE_NESTED:
+		return build_nested(graph, kind, num_nodes);
+	}
+}
+
+int
+compare_u64(const void* a, const void* b)
+{
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+// Sum of the run times of the tasks run so far.
+void
+read_counters(daggle_instance_h instance, uint64_t* out_tasks,
+	uint64_t* out_busy_ns)
+{
+	daggle_executor_statistics_t statistics;
+	daggle_instance_get_executor_statistics(instance, &statistics);
+
+	*out_tasks = statistics.total.tasks_executed;
+	*out_busy_ns
+		= statistics.total.run_time.mean_ns * statistics.total.run_time.count;
+}
+
+daggle_error_code_t
+measure(daggle_instance_h instance, const options_t* options, shape_t shape,
+	kind_t kind, uint64_t num_threads, result_t* out_result)
+{
+	daggle_graph_h graph;
+	daggle_error_code_t error = daggle_graph_create(instance, &graph);
+	if (error != DAGGLE_SUCCESS) {
+		return error;
+	}
+
+	shape_info_t info = build_graph(graph, shape, kind, options->num_nodes);
+
+	// Builds the plan and warms up the pools.
+	error = daggle_graph_execute(instance, graph);
+	if (error != DAGGLE_SUCCESS) {
+		return error;
+	}
+
+	uint64_t tasks_before;
+	uint64_t busy_before;
+	read_counters(instance, &tasks_before, &busy_before);
+
+	uint64_t* makespans = malloc(sizeof(uint64_t) * options->num_repeats);
+	if (!makespans) {
+		return DAGGLE_ERROR_MEMORY_ALLOCATION;
+	}
+
+	for (uint64_t i = 0; i < options->num_repeats; ++i) {
+		uint64_t start = now_ns();
+		error = daggle_graph_execute(instance, graph);
+		makespans[i] = now_ns() - start;
+
+		if (error != DAGGLE_SUCCESS) {
+			free(makespans);
+			return error;
+		}
+	}
+
+	uint64_t tasks_after;
+	uint64_t busy_after;
+	read_counters(instance, &tasks_after, &busy_after);
+
+	qsort(makespans, options->num_repeats, sizeof(uint64_t), compare_u64);
+
+	out_result->makespan_ns = makespans[options->num_repeats / 2];
+	out_result->makespan_min_ns = makespans[0];
+	out_result->num_tasks = (tasks_after - tasks_before) / options->num_repeats;
+	out_result->busy_ns = (busy_after - busy_before) / options->num_repeats;
+
+	// Bound by either the work spread over the threads or the longest path.
+	uint64_t work_ns = kind == KIND_SPIN ? spin_work_ns : 0;
+	uint64_t spread_ns = info.num_work_nodes * work_ns / num_threads;
+	uint64_t path_ns = info.depth * work_ns;
+	out_result->ideal_ns = spread_ns > path_ns ? spread_ns : path_ns;
+
+	free(makespans);
+	daggle_graph_free(graph);
+
+	return DAGGLE_SUCCESS;
+}
+
+void
+write_result(FILE* stream, shape_t shape, kind_t kind, uint64_t num_threads,
+	const result_t* result, const result_t* single_thread, bool is_first)
+{
+	double seconds = (double)result->makespan_ns * 1e-9;
+	double tasks_per_second
+		= seconds > 0 ? (double)result->num_tasks / seconds : 0;
+
+	// Thread time not spent running task bodies, per task. Includes the time
+	// threads idle for lack of parallelism.
+	double thread_ns = (double)result->makespan_ns * (double)num_threads;
+	double overhead_ns = result->num_tasks > 0
+		? (thread_ns - (double)result->busy_ns) / (double)result->num_tasks
+		: 0;
+
+	fprintf(stream,
+		"%s    {\"shape\": \"%s\", \"kind\": \"%s\", \"threads\": %llu, "
+		"\"tasks\": %llu, \"makespan_ns\": %llu, \"makespan_min_ns\": %llu, "
+		"\"tasks_per_second\": %.1f, \"overhead_ns_per_task\": %.1f, "
+		"\"ideal_makespan_ns\": %llu, ",
+		is_first ? "" : ",\n", shape_names[shape], kind_names[kind],
+		(unsigned long long)num_threads, (unsigned long long)result->num_tasks,
+		(unsigned long long)result->makespan_ns,
+		(unsigned long long)result->makespan_min_ns, tasks_per_second,
+		overhead_ns, (unsigned long long)result->ideal_ns);
+
+	// Trivial nodes have no work to compare to.
+	if (result->ideal_ns > 0) {
+		fprintf(stream, "\"makespan_vs_ideal\": %.3f, ",
+			(double)result->makespan_ns / (double)result->ideal_ns);
+	} else {
+		fprintf(stream, "\"makespan_vs_ideal\": null, ");
+	}
+
+	// Relative to the first thread count, one unless given otherwise.
+	if (single_thread->makespan_ns > 0 && result->makespan_ns > 0) {
+		fprintf(stream, "\"speedup\": %.3f}",
+			(double)single_thread->makespan_ns / (double)result->makespan_ns);
+	} else {
+		fprintf(stream, "\"speedup\": null}");
+	}
+}
+
+// Parse a comma-separated list of thread counts.
+bool
+parse_thread_counts(const char* list, options_t* options)
+{
+	options->num_thread_counts = 0;
+
+	const char* c = list;
+	while (*c && options->num_thread_counts < MAX_THREAD_COUNTS) {
+		char* end;
+		uint64_t count = strtoull(c, &end, 10);
+		if (end == c || count == 0) {
+			return false;
+		}
+
+		options->thread_counts[options->num_thread_counts++] = count;
+
+		c = *end == ',' ? end + 1 : end;
+	}
+
+	return options->num_thread_counts > 0;
+}
+
+bool
+parse_shapes(const char* list, options_t* options)
+{
+	for (int i = 0; i < NUM_SHAPES; ++i) {
+		options->shapes[i] = false;
+	}
+
+	const char* c = list;
+	while (*c) {
+		const char* end = strchr(c, ',');
+		uint64_t len = end ? (uint64_t)(end - c) : strlen(c);
+
+		bool is_known = false;
+		for (int i = 0; i < NUM_SHAPES; ++i) {
+			if (strlen(shape_names[i]) == len
+				&& strncmp(shape_names[i], c, len) == 0) {
+				options->shapes[i] = true;
+				is_known = true;
+			}
+		}
+
+		if (!is_known) {
+			return false;
+		}
+
+		c = end ? end + 1 : c + len;
+	}
+
+	return true;
+}
+
+bool
+parse_options(int argc, char** argv, options_t* options)
+{
+	options->num_nodes = 2000;
+	options->num_repeats = 5;
+	options->spin_ns = 10000;
+	options->output_path = NULL;
+
+	for (int i = 0; i < NUM_SHAPES; ++i) {
+		options->shapes[i] = true;
+	}
+
+	// Powers of two up to the number of CPUs, and the number of CPUs.
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_cpus < 1) {
+		num_cpus = 1;
+	}
+
+	options->num_thread_counts = 0;
+	for (uint64_t count = 1; count < (uint64_t)num_cpus
+		&& options->num_thread_counts < MAX_THREAD_COUNTS - 1;
+		count *= 2) {
+		options->thread_counts[options->num_thread_counts++] = count;
+	}
+	options->thread_counts[options->num_thread_counts++] = num_cpus;
+
+	for (int i = 1; i < argc; ++i) {
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (!value) {
+			return false;
+		}
+
+		if (strcmp(argv[i], "--nodes") == 0) {
+			options->num_nodes = strtoull(value, NULL, 10);
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			if (!parse_thread_counts(value, options)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "--repeat") == 0) {
+			options->num_repeats = strtoull(value, NULL, 10);
+		} else if (strcmp(argv[i], "--spin-ns") == 0) {
+			options->spin_ns = strtoull(value, NULL, 10);
+		} else if (strcmp(argv[i], "--shapes") == 0) {
+			if (!parse_shapes(value, options)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "--output") == 0) {
+			options->output_path = value;
+		} else {
+			return false;
+		}
+
+		++i;
+	}
+
+	return options->num_nodes > 0 && options->num_repeats > 0;
+}
+
+int
+main(int argc, char** argv)
+{
+	options_t options;
+	if (!parse_options(argc, argv, &options)) {
+		fprintf(stderr,
+			"Usage: daggle_bench [--nodes N] [--threads 1,2,4] [--repeat N] "
+			"[--spin-ns NS] [--shapes chain,fan,diamond,layered,nested] "
+			"[--output PATH]\n");
+		return EXIT_FAILURE;
+	}
+
+	FILE* stream = stderr;
+	if (options.output_path) {
+		stream = fopen(options.output_path, "w");
+		if (!stream) {
+			fprintf(stderr, "Can't open %s\n", options.output_path);
+			return EXIT_FAILURE;
+		}
+	}
+
+	calibrate_spin(options.spin_ns);
+
+	// Single threaded results of every shape and kind, to compute speedups.
+	result_t single_thread[NUM_SHAPES][NUM_KINDS];
+	memset(single_thread, 0, sizeof single_thread);
+
+	fprintf(stream,
+		"{\n  \"nodes\": %llu,\n  \"repeats\": %llu,\n  \"spin_ns\": %llu,\n"
+		"  \"results\": [\n",
+		(unsigned long long)options.num_nodes,
+		(unsigned long long)options.num_repeats,
+		(unsigned long long)spin_work_ns);
+
+	int result = EXIT_SUCCESS;
+	bool is_first = true;
+
+	for (uint64_t t = 0; t < options.num_thread_counts; ++t) {
+		uint64_t num_threads = options.thread_counts[t];
+
+		daggle_plugin_source_t core_source;
+		daggle_plugin_source_t graph_source;
+		daggle_plugin_source_create_from_file(CORE_PATH, &core_source);
+		daggle_plugin_source_create_from_file(GRAPH_PATH, &graph_source);
+
+		daggle_plugin_source_t* plugins[] = { &core_source, &graph_source };
+
+		// Every run executes every node, and reports the task durations.
+		daggle_instance_options_t instance_options;
+		daggle_instance_options_init(&instance_options);
+		instance_options.num_threads = num_threads;
+		instance_options.incremental_execution = false;
+		instance_options.memo_capacity = 0;
+		instance_options.task_timing = true;
+
+		daggle_instance_h instance;
+		daggle_instance_create_with_options(plugins, 2, &instance_options,
+			&instance);
+
+		daggle_plugin_register_node(instance, "bench_trivial", bench_trivial);
+		daggle_plugin_register_node(instance, "bench_spin", bench_spin);
+
+		for (int shape = 0; shape < NUM_SHAPES; ++shape) {
+			if (!options.shapes[shape]) {
+				continue;
+			}
+
+			for (int kind = 0; kind < NUM_KINDS; ++kind) {
+				result_t measured;
+				daggle_error_code_t error = measure(instance, &options,
+					shape, kind, num_threads, &measured);
+				if (error != DAGGLE_SUCCESS) {
+					fprintf(stderr, "Measuring %s %s failed with error %d\n",
+						shape_names[shape], kind_names[kind], (int)error);
+					result = EXIT_FAILURE;
+					continue;
+				}
+
+				if (t == 0) {
+					single_thread[shape][kind] = measured;
+				}
+
+				write_result(stream, shape, kind, num_threads, &measured,
+					&single_thread[shape][kind], is_first);
+				is_first = false;
+			}
+		}
+
+		daggle_instance_free(instance);
+	}
+
+	fprintf(stream, "\n  ]\n}\n");
+
+	if (stream != stderr) {
+		fclose(stream);
+	}
+
+	return result;
+}
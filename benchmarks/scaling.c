@@ -0,0 +1,222 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "time.h"
+
+#include <daggle/daggle.h>
+
+// Builds, compiles, serializes and deserializes graphs of growing size, and
+// checks that the time per node stays roughly constant. The results are
+// printed to stderr, the logs of the library go to stdout.
+//
+// Usage: benchmark_scaling [largest number of nodes]
+
+#define PLUGIN_ROOT_PATH "plugins/"
+#define CORE_PATH PLUGIN_ROOT_PATH "/core/plugin/core.daggle"
+
+// Number of graph sizes measured, each four times as large as the previous.
+#define NUM_SIZES 4
+
+// Allowed growth of the time per node from the smallest to the largest size.
+// Linear paths stay well below, quadratic ones exceed it by far.
+#define MAX_SLOWDOWN 4.0
+
+// Sizes below are too small for the time per node to be meaningful.
+#define MIN_MEASURED_NODES 10000
+
+typedef enum {
+	PHASE_BUILD,
+	PHASE_COMPILE,
+	PHASE_SERIALIZE,
+	PHASE_DESERIALIZE,
+	NUM_PHASES
+} phase_t;
+
+const char* phase_names[NUM_PHASES]
+	= { "build", "compile", "serialize", "deserialize" };
+
+double
+now_seconds(void)
+{
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+// Node i adds the results of nodes i - 1 and i / 2, so every node but the
+// first has two dependencies and most have two dependants.
+daggle_error_code_t
+build_graph(daggle_instance_h instance, uint64_t num_nodes,
+	daggle_graph_h* out_graph)
+{
+	daggle_graph_h graph;
+	daggle_graph_create(instance, &graph);
+
+	daggle_port_h* results = malloc(sizeof(daggle_port_h) * num_nodes);
+	if (!results) {
+		return DAGGLE_ERROR_MEMORY_ALLOCATION;
+	}
+
+	for (uint64_t i = 0; i < num_nodes; ++i) {
+		daggle_node_h node;
+		daggle_error_code_t error = daggle_graph_add_node(graph, "math", &node);
+		if (error != DAGGLE_SUCCESS) {
+			free(results);
+			return error;
+		}
+
+		daggle_node_get_port_by_name(node, "result", results + i);
+
+		if (i == 0) {
+			continue;
+		}
+
+		daggle_port_h first;
+		daggle_port_h second;
+		daggle_node_get_port_by_name(node, "first", &first);
+		daggle_node_get_port_by_name(node, "second", &second);
+
+		daggle_port_connect(results[i - 1], first);
+		daggle_port_connect(results[i / 2], second);
+	}
+
+	free(results);
+
+	*out_graph = graph;
+
+	return DAGGLE_SUCCESS;
+}
+
+daggle_error_code_t
+measure(daggle_instance_h instance, uint64_t num_nodes,
+	double seconds[NUM_PHASES])
+{
+	double start = now_seconds();
+
+	daggle_graph_h graph;
+	daggle_error_code_t error = build_graph(instance, num_nodes, &graph);
+	if (error != DAGGLE_SUCCESS) {
+		return error;
+	}
+
+	seconds[PHASE_BUILD] = now_seconds() - start;
+
+	start = now_seconds();
+
+	daggle_plan_h plan;
+	error = daggle_graph_compile(graph, NULL, &plan);
+	if (error != DAGGLE_SUCCESS) {
+		return error;
+	}
+
+	seconds[PHASE_COMPILE] = now_seconds() - start;
+
+	daggle_plan_free(plan);
+
+	start = now_seconds();
+
+	unsigned char* bin;
+	uint64_t len;
+	error = daggle_graph_serialize(graph, &bin, &len);
+	if (error != DAGGLE_SUCCESS) {
+		return error;
+	}
+
+	seconds[PHASE_SERIALIZE] = now_seconds() - start;
+
+	start = now_seconds();
+
+	daggle_graph_h deserialized;
+	error = daggle_graph_deserialize(instance, bin, &deserialized);
+	if (error != DAGGLE_SUCCESS) {
+		return error;
+	}
+
+	seconds[PHASE_DESERIALIZE] = now_seconds() - start;
+
+	free(bin);
+	daggle_graph_free(deserialized);
+	daggle_graph_free(graph);
+
+	return DAGGLE_SUCCESS;
+}
+
+int
+main(int argc, char** argv)
+{
+	uint64_t max_nodes = 1000000;
+	if (argc > 1) {
+		max_nodes = strtoull(argv[1], NULL, 10);
+	}
+
+	daggle_plugin_source_t core_source;
+	daggle_plugin_source_create_from_file(CORE_PATH, &core_source);
+
+	daggle_plugin_source_t* plugins[] = { &core_source };
+
+	daggle_instance_h instance;
+	daggle_instance_create(plugins, 1, &instance);
+
+	uint64_t sizes[NUM_SIZES];
+	double seconds[NUM_SIZES][NUM_PHASES];
+
+	for (int i = NUM_SIZES - 1; i >= 0; --i) {
+		sizes[i] = i == NUM_SIZES - 1 ? max_nodes : sizes[i + 1] / 4;
+	}
+
+	fprintf(stderr, "%12s", "nodes");
+	for (int phase = 0; phase < NUM_PHASES; ++phase) {
+		fprintf(stderr, "%14s", phase_names[phase]);
+	}
+	fprintf(stderr, "%14s\n", "(ns per node)");
+
+	for (int i = 0; i < NUM_SIZES; ++i) {
+		if (sizes[i] < 2) {
+			continue;
+		}
+
+		daggle_error_code_t error = measure(instance, sizes[i], seconds[i]);
+		if (error != DAGGLE_SUCCESS) {
+			fprintf(stderr, "Measuring %llu nodes failed with error %d\n",
+				(unsigned long long)sizes[i], (int)error);
+			return EXIT_FAILURE;
+		}
+
+		fprintf(stderr, "%12llu", (unsigned long long)sizes[i]);
+		for (int phase = 0; phase < NUM_PHASES; ++phase) {
+			fprintf(stderr, "%14.1f", seconds[i][phase] * 1e9 / sizes[i]);
+		}
+		fprintf(stderr, "\n");
+	}
+
+	daggle_instance_free(instance);
+
+	// Compare the largest size to the smallest one large enough to measure.
+	int first = 0;
+	while (first < NUM_SIZES - 1 && sizes[first] < MIN_MEASURED_NODES) {
+		++first;
+	}
+
+	int last = NUM_SIZES - 1;
+	if (first == last) {
+		fprintf(stderr, "Too few nodes to check the scaling\n");
+		return EXIT_SUCCESS;
+	}
+
+	int result = EXIT_SUCCESS;
+	for (int phase = 0; phase < NUM_PHASES; ++phase) {
+		double first_per_node = seconds[first][phase] / sizes[first];
+		double last_per_node = seconds[last][phase] / sizes[last];
+		double slowdown = last_per_node / first_per_node;
+
+		if (slowdown > MAX_SLOWDOWN) {
+			fprintf(stderr, "%s scales superlinearly: %.1fx slower per node\n",
+				phase_names[phase], slowdown);
+			result = EXIT_FAILURE;
+		}
+	}
+
+	return result;
+}
@@ -17,3 +17,6 @@ serialize_float(daggle_instance_h instance, const void* data,
 void
 deserialize_float(daggle_instance_h instance, const unsigned char* bin,
 	uint64_t len, void** target);
+
+uint64_t
+hash_float(daggle_instance_h instance, const void* data);
@@ -16,3 +16,6 @@ serialize_string(daggle_instance_h instance, const void* data,
 void
 deserialize_string(daggle_instance_h instance, const unsigned char* bin,
 	uint64_t len, void** target);
+
+uint64_t
+hash_string(daggle_instance_h instance, const void* data);
@@ -1,6 +1,7 @@
 #include "nodes/input.h"
 #include "nodes/math.h"
 #include "nodes/output.h"
+#include "stdalign.h"
 #include "types.h"
 #include "types/bool.h"
 #include "types/bytes.h"
@@ -21,22 +22,35 @@ PLUGIN_API void
 initialize(daggle_instance_h instance)
 {
 	daggle_plugin_register_type(instance, INT_TYPE, clone_int, free_int,
-		serialize_int, deserialize_int);
+		serialize_int, deserialize_int, hash_int);
 
 	daggle_plugin_register_type(instance, FLOAT_TYPE, clone_float, free_float,
-		serialize_float, deserialize_float);
+		serialize_float, deserialize_float, hash_float);
 
 	daggle_plugin_register_type(instance, DOUBLE_TYPE, clone_double, free_float,
-		serialize_double, deserialize_double);
+		serialize_double, deserialize_double, hash_double);
 
 	daggle_plugin_register_type(instance, BOOL_TYPE, clone_bool, free_bool,
-		serialize_bool, deserialize_bool);
+		serialize_bool, deserialize_bool, hash_bool);
 
 	daggle_plugin_register_type(instance, STRING_TYPE, clone_string,
-		free_string, serialize_string, deserialize_string);
+		free_string, serialize_string, deserialize_string, hash_string);
 
 	daggle_plugin_register_type(instance, BYTES_TYPE, clone_bytes, free_bytes,
-		serialize_bytes, deserialize_bytes);
+		serialize_bytes, deserialize_bytes, NULL);
+
+	// Scalars are stored inline in the ports.
+	daggle_plugin_register_type_layout(instance, INT_TYPE, sizeof(int32_t),
+		alignof(int32_t), true);
+	daggle_plugin_register_type_layout(instance, FLOAT_TYPE, sizeof(float),
+		alignof(float), true);
+	daggle_plugin_register_type_layout(instance, DOUBLE_TYPE, sizeof(double),
+		alignof(double), true);
+	daggle_plugin_register_type_layout(instance, BOOL_TYPE, sizeof(bool),
+		alignof(bool), true);
+
+	// Buffers are shared by the consumers instead of copied for each.
+	daggle_plugin_register_type_shared(instance, BYTES_TYPE);
 
 	daggle_plugin_register_node(instance, "input", input);
 	daggle_plugin_register_node(instance, "math", math);
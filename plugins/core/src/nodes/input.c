@@ -4,24 +4,34 @@
 #include "stdlib.h"
 #include "types.h"
 
+// Ids of the ports, resolved once in the declaration.
+typedef struct input_ports {
+	daggle_node_h node;
+
+	daggle_port_id_t value;
+	daggle_port_id_t result;
+} input_ports_t;
+
 void
 input_impl(daggle_task_h task, void* context)
 {
-	daggle_node_h handle = context;
+	input_ports_t* ports = context;
+	daggle_node_h handle = ports->node;
 
 	daggle_port_h value_parameter;
-	daggle_node_get_port_by_name(handle, "value", &value_parameter);
+	daggle_node_get_port_by_id(handle, ports->value, &value_parameter);
 
 	daggle_port_h result_output;
-	daggle_node_get_port_by_name(handle, "result", &result_output);
+	daggle_node_get_port_by_id(handle, ports->result, &result_output);
 
-	const char* type;
-	daggle_port_get_value_data_type(value_parameter, &type);
+	daggle_type_h type;
+	daggle_port_get_value_type(value_parameter, &type);
 
 	void* value;
 	daggle_port_get_value(value_parameter, &value);
 
-	daggle_port_set_value(result_output, type, value);
+	// The parameter keeps its value, every execution outputs a copy.
+	daggle_port_set_value_copy(result_output, type, value);
 }
 
 DEFAULT_VALUE_GENERATOR(input_gdv_value, int32_t, 1, INT_TYPE)
@@ -29,7 +39,12 @@ DEFAULT_VALUE_GENERATOR(input_gdv_value, int32_t, 1, INT_TYPE)
 void
 input(daggle_node_h handle)
 {
-	daggle_node_declare_parameter(handle, "value", input_gdv_value);
-	daggle_node_declare_output(handle, "result");
+	input_ports_t* ports = malloc(sizeof *ports);
+	ports->node = handle;
+
+	daggle_node_declare_parameter(handle, "value", input_gdv_value,
+		&ports->value);
+	daggle_node_declare_output(handle, "result", &ports->result);
 	daggle_node_declare_task(handle, input_impl);
+	daggle_node_declare_context(handle, ports, free);
 }
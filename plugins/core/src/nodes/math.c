@@ -4,9 +4,21 @@
 #include "stdlib.h"
 #include "types.h"
 
-typedef struct math_context {
+// Ids of the ports, resolved once in the declaration.
+typedef struct math_ports {
 	daggle_node_h node;
 
+	daggle_port_id_t first;
+	daggle_port_id_t second;
+	daggle_port_id_t operation;
+	daggle_port_id_t result;
+
+	daggle_type_h int_type;
+} math_ports_t;
+
+typedef struct math_context {
+	const math_ports_t* ports;
+
 	int32_t first;
 	int32_t second;
 	int32_t operation;
@@ -18,27 +30,20 @@ void
 math_read_fn(daggle_task_h task, void* context)
 {
 	math_context_t* math_context = context;
+	const math_ports_t* ports = math_context->ports;
 
 	daggle_port_h firstPort;
 	daggle_port_h secondPort;
 	daggle_port_h operationPort;
 
-	daggle_node_get_port_by_name(math_context->node, "first", &firstPort);
-	daggle_node_get_port_by_name(math_context->node, "second", &secondPort);
-	daggle_node_get_port_by_name(math_context->node, "operation",
+	daggle_node_get_port_by_id(ports->node, ports->first, &firstPort);
+	daggle_node_get_port_by_id(ports->node, ports->second, &secondPort);
+	daggle_node_get_port_by_id(ports->node, ports->operation,
 		&operationPort);
 
-	int32_t* first;
-	int32_t* second;
-	int32_t* operation;
-
-	daggle_port_get_value(firstPort, (void**)&first);
-	daggle_port_get_value(secondPort, (void**)&second);
-	daggle_port_get_value(operationPort, (void**)&operation);
-
-	math_context->first = *first;
-	math_context->second = *second;
-	math_context->operation = *operation;
+	daggle_port_get_i32(firstPort, &math_context->first);
+	daggle_port_get_i32(secondPort, &math_context->second);
+	daggle_port_get_i32(operationPort, &math_context->operation);
 }
 
 void
@@ -71,12 +76,12 @@ math_write_fn(daggle_task_h task, void* context)
 {
 	math_context_t* math_context = context;
 
+	const math_ports_t* ports = math_context->ports;
+
 	daggle_port_h outputPort;
-	daggle_node_get_port_by_name(math_context->node, "result", &outputPort);
+	daggle_node_get_port_by_id(ports->node, ports->result, &outputPort);
 
-	int32_t* result = malloc(sizeof *result);
-	*result = math_context->result;
-	daggle_port_set_value(outputPort, INT_TYPE, result);
+	daggle_port_set_i32(outputPort, ports->int_type, math_context->result);
 }
 
 void
@@ -89,7 +94,7 @@ void
 math_impl(daggle_task_h task, void* context)
 {
 	math_context_t* math_context = malloc(sizeof *math_context);
-	math_context->node = context;
+	math_context->ports = context;
 
 	daggle_task_h reader_task;
 	daggle_task_create(math_read_fn, NULL, math_context, "math_read\0",
@@ -118,11 +123,20 @@ DEFAULT_VALUE_GENERATOR(math_gdv_operation, int32_t, 0, INT_TYPE)
 void
 math(daggle_node_h handle)
 {
+	daggle_instance_h instance;
+	daggle_node_get_daggle(handle, &instance);
+
+	math_ports_t* ports = malloc(sizeof *ports);
+	ports->node = handle;
+	daggle_data_get_type(instance, INT_TYPE, &ports->int_type);
+
 	daggle_node_declare_input(handle, "first", DAGGLE_INPUT_BEHAVIOR_ACQUIRE,
-		math_gdv_first);
+		math_gdv_first, &ports->first);
 	daggle_node_declare_input(handle, "second",
-		DAGGLE_INPUT_BEHAVIOR_ACQUIRE, math_gdv_second);
-	daggle_node_declare_parameter(handle, "operation", math_gdv_operation);
-	daggle_node_declare_output(handle, "result");
+		DAGGLE_INPUT_BEHAVIOR_ACQUIRE, math_gdv_second, &ports->second);
+	daggle_node_declare_parameter(handle, "operation", math_gdv_operation,
+		&ports->operation);
+	daggle_node_declare_output(handle, "result", &ports->result);
 	daggle_node_declare_task(handle, math_impl);
+	daggle_node_declare_context(handle, ports, free);
 }
@@ -6,25 +6,33 @@
 #include "stdlib.h"
 #include "types.h"
 
+// Ids of the ports, resolved once in the declaration.
+typedef struct output_ports {
+	daggle_node_h node;
+
+	daggle_port_id_t value;
+	daggle_port_id_t message;
+} output_ports_t;
+
 void
 output_impl(daggle_task_h task, void* context)
 {
-	daggle_node_h handle = context;
+	output_ports_t* ports = context;
+	daggle_node_h handle = ports->node;
 
 	daggle_port_h messagePort;
 	daggle_port_h valuePort;
 
-	daggle_node_get_port_by_name(handle, "message", &messagePort);
-	daggle_node_get_port_by_name(handle, "value", &valuePort);
+	daggle_node_get_port_by_id(handle, ports->message, &messagePort);
+	daggle_node_get_port_by_id(handle, ports->value, &valuePort);
 
 	void* message;
 	daggle_port_get_value(messagePort, &message);
 
-	void* value;
-	daggle_port_get_value(valuePort, &value);
+	int32_t val = 0;
+	daggle_port_get_i32(valuePort, &val);
 
 	char* msg = (char*)message;
-	int32_t val = *(int32_t*)value;
 
 	printf("%s%i\n", msg, val);
 }
@@ -53,9 +61,16 @@ output_gdv_message(void** out_data, const char** out_type)
 void
 output(daggle_node_h handle)
 {
+	output_ports_t* ports = malloc(sizeof *ports);
+	ports->node = handle;
+
 	daggle_node_declare_input(handle, "value", DAGGLE_INPUT_BEHAVIOR_ACQUIRE,
-		output_gdv_value);
+		output_gdv_value, &ports->value);
 	daggle_node_declare_input(handle, "message",
-		DAGGLE_INPUT_BEHAVIOR_REFERENCE, output_gdv_message);
+		DAGGLE_INPUT_BEHAVIOR_REFERENCE, output_gdv_message, &ports->message);
 	daggle_node_declare_task(handle, output_impl);
+	daggle_node_declare_context(handle, ports, free);
+
+	// Prints on every execution, not only when the value changes.
+	daggle_node_declare_volatile(handle);
 }
@@ -38,3 +38,9 @@ deserialize_bool(daggle_instance_h instance, const unsigned char* bin,
 
 	clone_bool(instance, bin, target);
 }
+
+uint64_t
+hash_bool(daggle_instance_h instance, const void* data)
+{
+	return *((const bool*)data) ? 1 : 0;
+}
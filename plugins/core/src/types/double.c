@@ -1,5 +1,7 @@
 #include "types/double.h"
 
+#include "string.h"
+
 void
 clone_double(daggle_instance_h instance, const void* data, void** target)
 {
@@ -36,3 +38,18 @@ deserialize_double(daggle_instance_h instance, const unsigned char* bin,
 
 	clone_double(instance, bin, target);
 }
+
+uint64_t
+hash_double(daggle_instance_h instance, const void* data)
+{
+	// Zero and negative zero are equal.
+	double val = *((const double*)data);
+	if (val == 0.0) {
+		val = 0.0;
+	}
+
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof bits);
+
+	return bits;
+}
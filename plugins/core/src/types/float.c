@@ -1,5 +1,7 @@
 #include "types/float.h"
 
+#include "string.h"
+
 void
 clone_float(daggle_instance_h instance, const void* data, void** target)
 {
@@ -36,3 +38,18 @@ deserialize_float(daggle_instance_h instance, const unsigned char* bin,
 
 	clone_float(instance, bin, target);
 }
+
+uint64_t
+hash_float(daggle_instance_h instance, const void* data)
+{
+	// Zero and negative zero are equal.
+	float val = *((const float*)data);
+	if (val == 0.0f) {
+		val = 0.0f;
+	}
+
+	uint32_t bits;
+	memcpy(&bits, &val, sizeof bits);
+
+	return bits;
+}
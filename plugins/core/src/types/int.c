@@ -38,3 +38,9 @@ deserialize_int(daggle_instance_h instance, const unsigned char* bin,
 
 	clone_int(instance, bin, target);
 }
+
+uint64_t
+hash_int(daggle_instance_h instance, const void* data)
+{
+	return (uint64_t)(uint32_t)*((const int32_t*)data);
+}
@@ -47,3 +47,19 @@ deserialize_string(daggle_instance_h instance, const unsigned char* bin,
 
 	*target = res;
 }
+
+uint64_t
+hash_string(daggle_instance_h instance, const void* data)
+{
+	// FNV-1a. Must match fnv1a_64 of the library, which is not part of its
+	// public API.
+	uint64_t hash = 0xcbf29ce484222325;
+
+	const unsigned char* s = data;
+	while (*s) {
+		hash ^= *s++;
+		hash *= 0x00000100000001b3;
+	}
+
+	return hash;
+}
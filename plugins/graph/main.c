@@ -75,70 +75,90 @@ null_default_value(void** out_data, const char** out_type)
 	return true;
 }
 
-void
-input_bridge_impl(daggle_task_h task, void* context)
-{
-	daggle_port_h in;
-	daggle_port_h out;
+// Ids of the ports of a bridge node, resolved once in the declaration. The
+// value flows from the in port to the out port.
+typedef struct bridge_ports_s {
+	daggle_node_h node;
 
-	daggle_node_get_port_by_name(context, "_bridge", &in);
-	daggle_node_get_port_by_name(context, "value", &out);
-
-	const char* in_type = NULL;
-	void* in_value = NULL;
-
-	daggle_port_get_value_data_type(in, &in_type);
-	daggle_port_get_value(in, &in_value);
-
-	daggle_port_set_value(out, in_type, in_value);
-}
+	daggle_port_id_t in;
+	daggle_port_id_t out;
+} bridge_ports_t;
 
 void
-output_bridge_impl(daggle_task_h task, void* context)
+bridge_impl(daggle_task_h task, void* context)
 {
+	bridge_ports_t* ports = context;
+
 	daggle_port_h in;
 	daggle_port_h out;
 
-	daggle_node_get_port_by_name(context, "value", &in);
-	daggle_node_get_port_by_name(context, "_bridge", &out);
+	daggle_node_get_port_by_id(ports->node, ports->in, &in);
+	daggle_node_get_port_by_id(ports->node, ports->out, &out);
 
-	const char* in_type = NULL;
-	void* in_value = NULL;
+	// Values of shared types pass through without a copy.
+	daggle_value_h value = NULL;
+	daggle_port_get_shared_value(in, &value);
 
-	daggle_port_get_value_data_type(in, &in_type);
-	daggle_port_get_value(in, &in_value);
+	if (!value) {
+		return;
+	}
 
-	daggle_port_set_value(out, in_type, in_value);
+	daggle_port_set_shared_value(out, value);
 }
 
 void
 input_bridge(daggle_node_h handle)
 {
-	daggle_node_declare_parameter(handle, "name", bridge_name_default_value);
-	daggle_node_declare_output(handle, "value");
+	bridge_ports_t* ports = malloc(sizeof *ports);
+	ports->node = handle;
+
+	daggle_node_declare_parameter(handle, "name", bridge_name_default_value,
+		NULL);
+	daggle_node_declare_output(handle, "value", &ports->out);
 
 	daggle_node_declare_input(handle, "_bridge", DAGGLE_INPUT_BEHAVIOR_ACQUIRE,
-		null_default_value);
+		null_default_value, &ports->in);
 
-	daggle_node_declare_task(handle, input_bridge_impl);
+	daggle_node_declare_task(handle, bridge_impl);
+	daggle_node_declare_context(handle, ports, free);
 }
 
 void
 output_bridge(daggle_node_h handle)
 {
-	daggle_node_declare_parameter(handle, "name", bridge_name_default_value);
+	bridge_ports_t* ports = malloc(sizeof *ports);
+	ports->node = handle;
+
+	daggle_node_declare_parameter(handle, "name", bridge_name_default_value,
+		NULL);
 	daggle_node_declare_input(handle, "value", DAGGLE_INPUT_BEHAVIOR_ACQUIRE,
-		null_default_value);
+		null_default_value, &ports->in);
 
-	daggle_node_declare_output(handle, "_bridge");
+	daggle_node_declare_output(handle, "_bridge", &ports->out);
 
-	daggle_node_declare_task(handle, output_bridge_impl);
+	daggle_node_declare_task(handle, bridge_impl);
+	daggle_node_declare_context(handle, ports, free);
 }
 
+// A bridge node of the graph and the port of the invoker it is bridged to.
+typedef struct graph_invoker_bridge_s {
+	// The _bridge port of the bridge node.
+	daggle_port_h bridge;
+
+	// Id of the port of the invoker with the name of the bridge.
+	daggle_port_id_t port;
+
+	bool is_input;
+} graph_invoker_bridge_t;
+
 typedef struct graph_invoker_context_s {
 	daggle_instance_h daggle;
 	daggle_node_h handle;
 	daggle_graph_h graph;
+
+	// Resolved in the declaration, so invocations don't look the ports up.
+	graph_invoker_bridge_t* bridges;
+	uint64_t num_bridges;
 } graph_invoker_context_t;
 
 void
@@ -185,59 +205,59 @@ graph_invoker_context_dispose(void* context)
 		// graph_free(ctx->graph);
 	}
 
+	free(ctx->bridges);
 	free(ctx);
 }
 
-void
-bridge_ports(daggle_port_h from, daggle_port_h to)
-{
-	const char* type = NULL;
-	void* data = NULL;
-
-	daggle_port_get_value_data_type(from, &type);
-	daggle_port_get_value(from, &data);
-
-	daggle_port_set_value(to, type, data);
-}
+// State of one invocation. Every invocation runs the graph in a context of
+// its own, so the invoker may be executed in many contexts at once.
+typedef struct graph_invoker_run_s {
+	graph_invoker_context_t* invoker;
+	daggle_execution_context_h context;
+} graph_invoker_run_t;
 
 void
-invoker_do_bridge(graph_invoker_context_t* ctx, bool is_write)
+invoker_do_bridge(graph_invoker_run_t* run, bool is_write)
 {
-	daggle_graph_h graph = ctx->graph;
-
-	uint64_t counter = 0;
-	daggle_node_h node = NULL;
-	while (true) {
-		daggle_graph_get_node_by_index(graph, counter++, &node);
+	graph_invoker_context_t* ctx = run->invoker;
 
-		if (!node) {
-			break;
-		}
-
-		const char* type = NULL;
-		daggle_node_get_type(node, &type);
+	for (uint64_t i = 0; i < ctx->num_bridges; ++i) {
+		graph_invoker_bridge_t* bridge = ctx->bridges + i;
 
-		if (strcmp(type, is_write ? "output_bridge" : "input_bridge") != 0) {
+		// Inputs are read into the graph, outputs written out of it.
+		if (bridge->is_input == is_write) {
 			continue;
 		}
 
-		daggle_port_h name_port;
-		daggle_node_get_port_by_name(node, "name", &name_port);
-
-		char* name_value;
-		daggle_port_get_value(name_port, (void**)(&name_value));
-
-		daggle_port_h bridge_value_port;
-		daggle_node_get_port_by_name(node, "_bridge", &bridge_value_port);
-
 		daggle_port_h invoker_value_port;
-		daggle_node_get_port_by_name(ctx->handle, name_value,
+		daggle_node_get_port_by_id(ctx->handle, bridge->port,
 			&invoker_value_port);
 
+		const char* type_name = NULL;
+		void* data = NULL;
+
 		if (is_write) {
-			bridge_ports(bridge_value_port, invoker_value_port);
+			// The context of the run is freed afterwards, hand out a
+			// reference, which copies values of types that aren't shared.
+			daggle_value_h value = NULL;
+			daggle_execution_context_get_shared_value(run->context,
+				bridge->bridge, &value);
+
+			if (!value) {
+				continue;
+			}
+
+			daggle_port_set_shared_value(invoker_value_port, value);
 		} else {
-			bridge_ports(invoker_value_port, bridge_value_port);
+			daggle_port_get_value_data_type(invoker_value_port, &type_name);
+			daggle_port_get_value(invoker_value_port, &data);
+
+			if (!data) {
+				continue;
+			}
+
+			daggle_execution_context_set_value(run->context, bridge->bridge,
+				type_name, data);
 		}
 	}
 }
@@ -254,20 +274,35 @@ invoker_read_task(daggle_task_h task, void* context)
 	invoker_do_bridge(context, false);
 }
 
+void
+invoker_run_dispose(void* context)
+{
+	graph_invoker_run_t* run = context;
+
+	daggle_execution_context_free(run->context);
+	free(run);
+}
+
 void
 graph_invoker_impl(daggle_task_h task, void* context)
 {
 	graph_invoker_context_t* ctx = context;
 	daggle_graph_h graph = ctx->graph;
 
+	graph_invoker_run_t* run = malloc(sizeof *run);
+	run->invoker = ctx;
+	daggle_execution_context_create(graph, &run->context);
+
 	daggle_task_h graph_task;
-	daggle_graph_taskify(graph, &graph_task);
+	daggle_graph_taskify_with_context(graph, run->context, &graph_task);
 
 	daggle_task_h read_task;
-	daggle_task_create(invoker_read_task, NULL, ctx, "read", &read_task);
+	daggle_task_create(invoker_read_task, NULL, run, "read", &read_task);
 
+	// The write runs last, after the graph has released the context.
 	daggle_task_h write_task;
-	daggle_task_create(invoker_write_task, NULL, ctx, "write", &write_task);
+	daggle_task_create(invoker_write_task, invoker_run_dispose, run, "write",
+		&write_task);
 
 	daggle_task_depend(graph_task, read_task);
 	daggle_task_depend(write_task, graph_task);
@@ -278,12 +313,15 @@ graph_invoker_impl(daggle_task_h task, void* context)
 }
 
 void
-graph_invoker_declare_graph_bridges(daggle_node_h handle, daggle_graph_h graph)
+graph_invoker_declare_graph_bridges(daggle_node_h handle,
+	graph_invoker_context_t* ctx)
 {
+	uint64_t capacity = 0;
+
 	daggle_node_h subnode = NULL;
 	uint64_t counter = 0;
 	while (true) {
-		daggle_graph_get_node_by_index(graph, counter++, &subnode);
+		daggle_graph_get_node_by_index(ctx->graph, counter++, &subnode);
 
 		if (!subnode) {
 			break;
@@ -305,11 +343,22 @@ graph_invoker_declare_graph_bridges(daggle_node_h handle, daggle_graph_h graph)
 		char* name_value;
 		daggle_port_get_value(name_port, (void**)(&name_value));
 
+		if (ctx->num_bridges == capacity) {
+			capacity = capacity ? capacity * 2 : 4;
+			ctx->bridges
+				= realloc(ctx->bridges, sizeof *ctx->bridges * capacity);
+		}
+
+		graph_invoker_bridge_t* bridge = ctx->bridges + ctx->num_bridges++;
+		bridge->is_input = is_input;
+		daggle_node_get_port_by_name(subnode, "_bridge", &bridge->bridge);
+
 		if (is_input) {
 			daggle_node_declare_input(handle, name_value,
-				DAGGLE_INPUT_BEHAVIOR_ACQUIRE, null_default_value);
+				DAGGLE_INPUT_BEHAVIOR_ACQUIRE, null_default_value,
+				&bridge->port);
 		} else {
-			daggle_node_declare_output(handle, name_value);
+			daggle_node_declare_output(handle, name_value, &bridge->port);
 		}
 	}
 }
@@ -317,8 +366,9 @@ graph_invoker_declare_graph_bridges(daggle_node_h handle, daggle_graph_h graph)
 void
 graph_invoker(daggle_node_h handle)
 {
-	daggle_node_declare_parameter(handle, "graph",
-		null_default_value); // Serialized graph
+	daggle_port_id_t graph_id;
+	daggle_node_declare_parameter(handle, "graph", null_default_value,
+		&graph_id); // Serialized graph
 
 	daggle_instance_h daggle;
 	daggle_node_get_daggle(handle, &daggle);
@@ -328,13 +378,15 @@ graph_invoker(daggle_node_h handle)
 	ctx->graph = NULL;
 	ctx->handle = handle;
 	ctx->daggle = daggle;
+	ctx->bridges = NULL;
+	ctx->num_bridges = 0;
 
 	daggle_port_h graph_port;
-	daggle_node_get_port_by_name(handle, "graph", &graph_port);
+	daggle_node_get_port_by_id(handle, graph_id, &graph_port);
 	daggle_port_get_value(graph_port, &ctx->graph);
 
 	if (ctx->graph) {
-		graph_invoker_declare_graph_bridges(handle, ctx->graph);
+		graph_invoker_declare_graph_bridges(handle, ctx);
 		daggle_node_declare_task(handle, graph_invoker_impl);
 	}
 
@@ -349,5 +401,6 @@ initialize(daggle_instance_h instance)
 	daggle_plugin_register_node(instance, "graph_invoker", graph_invoker);
 
 	daggle_plugin_register_type(instance, "graph_object", clone_graph_object,
-		free_graph_object, serialize_graph_object, deserialize_graph_object);
+		free_graph_object, serialize_graph_object, deserialize_graph_object,
+		NULL);
 }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "pthread.h"
+#include "resource_container.h"
+#include "stdbool.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+typedef struct atom_s {
+	uint32_t hash;
+	char name[];
+} atom_t;
+
+// Names interned for the lifetime of an instance. Node types, type names and
+// port names are stored once, and equal names have equal pointers, so they
+// may be compared by address. Open addressing by the hash of the name,
+// probing linearly.
+typedef struct atom_table_s {
+	// Names are interned and looked up from any thread.
+	pthread_mutex_t lock;
+
+	// Power of two, at least twice the number of atoms.
+	atom_t** slots;
+	uint64_t num_slots;
+	uint64_t num_atoms;
+} atom_table_t;
+
+daggle_error_code_t
+atom_table_init(atom_table_t* table);
+
+void
+atom_table_destroy(atom_table_t* table);
+
+// Write the interned copy of the name, adding it if it is new.
+daggle_error_code_t
+atom_table_intern(atom_table_t* table, const char* name,
+	name_with_hash_t* out_atom);
+
+// Write the interned copy of the name without adding it. Returns false if the
+// name has never been interned, so nothing can have the name.
+bool
+atom_table_find(atom_table_t* table, const char* name,
+	name_with_hash_t* out_atom);
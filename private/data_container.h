@@ -1,14 +1,31 @@
 #pragma once
 
 #include "resource_container.h"
+#include "shared_value.h"
+#include "stdalign.h"
+#include "stdbool.h"
+#include "stddef.h"
 #include "stdint.h"
 
 #include <daggle/daggle.h>
 
 typedef struct data_container_s {
+	// Points to inline_data for inline values. Containers holding one must
+	// not be copied, or moved without data_container_rebase.
 	void* data;
 	type_info_t* info;
 	daggle_instance_h instance;
+
+	// Reference held to the data of a shared type, NULL otherwise.
+	shared_value_t* shared;
+
+	// The data lives in the scratch arena of an execution context, which
+	// frees it, the type freer is not called.
+	bool is_scratch;
+
+	// The data is stored in inline_data, and needs no freeing either.
+	bool is_inline;
+	alignas(max_align_t) unsigned char inline_data[DAGGLE_INLINE_VALUE_SIZE];
 } data_container_t;
 
 void
@@ -26,5 +43,35 @@ void
 data_container_replace(data_container_t* container, type_info_t* type,
 	void* data);
 
+// Clear the container without freeing the value, which has been taken over.
+void
+data_container_forget(data_container_t* container);
+
+// Like data_container_replace, with data from the scratch arena of the
+// execution context holding the container.
+void
+data_container_replace_scratch(data_container_t* container, type_info_t* type,
+	void* data);
+
+// Hold a reference to a shared value, taking over the one of the caller.
+void
+data_container_replace_shared(data_container_t* container,
+	shared_value_t* value);
+
+// Copy the bytes of a value of an inline type into the container.
+void
+data_container_replace_inline(data_container_t* container, type_info_t* type,
+	const void* data);
+
+// Replace the value with a copy of the data, inline if the type allows it.
+// The data must not be owned by the container, unless it is scratch memory.
+void
+data_container_replace_copy(data_container_t* container, type_info_t* type,
+	const void* data);
+
+// Point an inline value back into the container after it has been moved.
+void
+data_container_rebase(data_container_t* container);
+
 bool
 data_container_has_value(const data_container_t* container);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "execution_context.h"
+#include "pthread.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+struct node_s;
+
+// Outputs of memoized nodes persisted in a directory, one file per key. The
+// files are written under a temporary name and renamed into place, so
+// processes sharing the directory only ever see complete results. The time
+// of the last modification orders the files for eviction; with the least
+// recently used policy it is refreshed on every load.
+typedef struct disk_cache_s {
+	// NULL if disabled.
+	char* directory;
+
+	// 0 for no limit.
+	uint64_t max_bytes;
+	daggle_cache_eviction_t eviction;
+
+	// Guards the size and the eviction.
+	pthread_mutex_t lock;
+
+	// Size of the files, as of the last scan of the directory and the writes
+	// since.
+	uint64_t num_bytes;
+
+	// Makes the temporary names unique within the process.
+	_Atomic(uint64_t) sequence;
+
+	_Atomic(uint64_t) hits;
+	_Atomic(uint64_t) writes;
+	_Atomic(uint64_t) evictions;
+} disk_cache_t;
+
+// A NULL directory disables the cache. The directory is created if missing.
+daggle_error_code_t
+disk_cache_init(const char* directory, uint64_t max_bytes,
+	daggle_cache_eviction_t eviction, disk_cache_t* cache);
+
+void
+disk_cache_destroy(disk_cache_t* cache);
+
+bool
+disk_cache_is_enabled(const disk_cache_t* cache);
+
+// Set the outputs of the node in the context to the deserialized outputs
+// stored for the key. Returns false if there are none, or they can't be read.
+bool
+disk_cache_load(disk_cache_t* cache, daggle_instance_h instance, uint64_t key,
+	struct node_s* node, execution_context_t* context);
+
+// Serialize the outputs of the node in the context to the file of the key,
+// and evict files if over the limit.
+void
+disk_cache_store(disk_cache_t* cache, daggle_instance_h instance,
+	uint64_t key, struct node_s* node, execution_context_t* context);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "utility/completion.h"
+
+#include <daggle/daggle.h>
+
+struct executor;
+
+// Tracks a submitted root task. Shared by the handle given to the caller and
+// the root task, freed when both have released it.
+typedef struct execution_s {
+	completion_t completion;
+
+	// Executor running the root task.
+	struct executor* executor;
+
+	daggle_execution_callback_fn callback;
+	void* callback_data;
+
+	_Atomic(uint32_t) references;
+
+	// Set by cancel, or by the first task to notice the deadline has passed.
+	_Atomic(bool) cancelled;
+
+	// Monotonic time after which the execution is cancelled, 0 if none.
+	_Atomic(uint64_t) deadline_ns;
+
+	// Whether any task was skipped due to the cancellation.
+	_Atomic(bool) skipped;
+
+	// Monotonic time of the creation, for the latency statistics.
+	uint64_t created_ns;
+} execution_t;
+
+daggle_error_code_t
+execution_create(struct executor* executor,
+	daggle_execution_callback_fn callback, void* callback_data,
+	execution_t** out_execution);
+
+void
+execution_release(execution_t* execution);
+
+// Called once the root task and all of its subtasks have been disposed.
+// Runs the callback, wakes the waiters and releases the reference of the task.
+void
+execution_complete(execution_t* execution);
+
+void
+execution_cancel(execution_t* execution);
+
+void
+execution_set_deadline(execution_t* execution, uint64_t timeout_ns);
+
+// Whether the execution was cancelled or its deadline has passed.
+bool
+execution_is_cancelled(execution_t* execution);
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "data_container.h"
+#include "pthread.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "stdint.h"
+#include "utility/arena.h"
+
+#include <daggle/daggle.h>
+
+struct graph_s;
+struct node_s;
+struct port_s;
+
+// State of a port within one execution context.
+typedef struct context_port_s {
+	// Output values, and input values set for this context only.
+	data_container_t value;
+
+	// Outputs: number of linked inputs which have yet to access the value.
+	_Atomic(uint32_t) num_pending_accesses;
+
+	// Inputs: whether the node has already accessed the value.
+	bool has_spent_access;
+} context_port_t;
+
+// State of a node within one execution context.
+typedef struct context_node_s {
+	// Version of the node last run to completion, 0 if never.
+	uint64_t version;
+
+	// Set when the node is scheduled, or an input value of the context
+	// changes, and cleared when it has run. Nodes left dirty by a cancelled
+	// execution run on the next one.
+	bool is_dirty;
+} context_node_t;
+
+// Values and access state of the ports of a graph. The graph itself only holds
+// the topology, parameters and default input values, so it can be run in many
+// contexts at once, one execution per context at a time.
+typedef struct execution_context_s {
+	struct graph_s* graph;
+
+	// Indexed by the slots of the ports.
+	context_port_t* ports;
+	uint64_t num_ports;
+
+	// Indexed by the slots of the nodes.
+	context_node_t* nodes;
+	uint64_t num_nodes;
+
+	// Set while a task graph created for the context is in flight.
+	_Atomic(bool) executing;
+
+	// Memory of the node tasks for the values of one execution, reset when the
+	// next one begins. The lock is only taken to add a chunk.
+	pthread_mutex_t scratch_lock;
+	arena_t scratch;
+} execution_context_t;
+
+void
+execution_context_init(struct graph_s* graph, execution_context_t* context);
+
+void
+execution_context_destroy(execution_context_t* context);
+
+// Claim the context for an execution, reset the access state of every port
+// and drop the values left in the scratch arena. Fails with
+// DAGGLE_ERROR_OBJECT_LOCKED if it is already executing.
+daggle_error_code_t
+execution_context_begin(execution_context_t* context);
+
+// Copy the values in the scratch arena which outlive the next execution to the
+// heap, and release the context.
+void
+execution_context_end(execution_context_t* context);
+
+// Memory for the duration of the current execution of the context, NULL if it
+// can't be allocated.
+void*
+execution_context_alloc_scratch(execution_context_t* context, uint64_t size,
+	uint64_t alignment);
+
+// State of a port of the graph of the context. Ports added after the context
+// was created are made room for, which must not happen during an execution.
+context_port_t*
+execution_context_get_port(execution_context_t* context, struct port_s* port);
+
+// Count an access of a linked input to an output as done. The last one
+// releases the value of the output, if the instance releases consumed values.
+void
+execution_context_finish_access(execution_context_t* context,
+	struct port_s* output);
+
+// Whether the value of an output is kept for the next execution, which is the
+// case when executing incrementally, unless its node runs on every execution
+// anyway.
+bool
+execution_context_is_output_retained(struct port_s* output);
+
+// State of a node of the graph of the context, made room for like the ports.
+context_node_t*
+execution_context_get_node(execution_context_t* context, struct node_s* node);
+
+// Whether a node has to run in the next execution of the context, regardless
+// of the nodes it depends on.
+bool
+execution_context_is_node_dirty(execution_context_t* context,
+	struct node_s* node);
+
+// Context holding the state of a port for the calling thread. Inside a task
+// running in a context of the graph of the port, that context, otherwise the
+// default context of the graph.
+execution_context_t*
+execution_context_resolve(struct port_s* port);
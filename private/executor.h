@@ -1,36 +1,158 @@
 #pragma once
 
 #include "pthread.h"
-#include "utility/closure.h"
-#include "utility/dynamic_array.h"
-#include "utility/thread_safe_linked_queue.h"
+#include "stdalign.h"
+#include "task.h"
+#include "task_queue.h"
+#include "trace_buffer.h"
+#include "utility/histogram.h"
+#include "utility/ws_deque.h"
 
 #include <daggle/daggle.h>
 
-typedef struct task_s {
-	void_closure_t work;
+struct executor;
+struct worker_group_s;
 
-	struct task_s* head; // Parent of the subgraph this is a part of
-	struct task_s* tail; // Tail of this' own subgraph
+// Counters of a worker. Only the worker itself writes them, so updates are
+// plain stores, other threads may read them at any time.
+typedef struct worker_statistics_s {
+	_Atomic(uint64_t) num_executed;
+	_Atomic(uint64_t) num_enqueued;
+	_Atomic(uint64_t) num_dequeued;
+	_Atomic(uint64_t) num_stolen;
+	_Atomic(uint64_t) max_queue_depth;
+	_Atomic(uint64_t) parked_ns;
 
-	uint64_t num_subtasks; // number of subtasks (incl. sink)
-	_Atomic(uint64_t) num_pending_subtasks; // this + sum of subtask progress
+	// Only recorded with timing enabled.
+	histogram_t run_time;
+	histogram_t queue_wait;
+} worker_statistics_t;
 
-	dynamic_array_t dependants;
-	_Atomic(uint64_t) num_pending_dependencies;
-} task_t;
+typedef struct worker_s {
+	// Tasks made ready by this worker. Other workers steal from here.
+	ws_deque_t deque;
+
+	// Tasks created on this worker are allocated from here.
+	task_pool_t pool;
+
+	pthread_t thread;
+	struct executor* executor;
+	struct worker_group_s* group;
+	uint64_t id;
+
+	// CPUs the worker is restricted to, none if unpinned.
+	uint64_t* cpus;
+	uint64_t num_cpus;
+
+	// State of the xorshift generator used to pick steal victims.
+	uint64_t steal_seed;
+
+	// Tasks run by this worker, disabled unless tracing.
+	trace_buffer_t trace;
+
+	// Kept apart from the fields read by the thieves.
+	alignas(64) worker_statistics_t statistics;
+} worker_t;
+
+// Workers sharing a NUMA node. Without NUMA awareness there is one group.
+typedef struct worker_group_s {
+	// Tasks submitted from outside of the workers.
+	task_queue_t queue;
+
+	uint64_t node;
+
+	// The workers of a group are stored contiguously.
+	uint64_t first_worker;
+	uint64_t num_workers;
+} worker_group_t;
 
 typedef struct executor {
-	ts_llist_queue_t queue;
-	pthread_t* workers;
-	volatile bool halt;
+	worker_t* workers;
+	uint64_t num_workers;
+
+	worker_group_t* groups;
+	uint64_t num_groups;
+
+	// NUMA node of each CPU id, all zero without NUMA awareness. Ids without
+	// a CPU are on TOPOLOGY_NO_NODE.
+	uint64_t* cpu_nodes;
+	uint64_t num_cpu_nodes;
+
+	// Idle workers wait on the condition.
+	pthread_mutex_t park_lock;
+	pthread_cond_t park_condition;
+
+	// Number of workers parked, or about to park.
+	_Atomic(uint64_t) num_sleeping;
+
+	// Run one of the dependants made ready by a task directly.
+	bool inline_continuation;
+
+	// Record the tasks run by the workers, see daggle_instance_options_t.
+	bool is_tracing;
+
+	// Measure when tasks become ready, start and end. Needed for the task
+	// durations in the statistics, and for tracing.
+	bool is_timing;
+
+	// Trace timestamps are relative to the creation of the executor.
+	uint64_t trace_epoch_ns;
+
+	// Tasks submitted from outside of the workers.
+	_Atomic(uint64_t) num_submitted;
+
+	// Time from creating to completing executions.
+	histogram_t execution_latency;
+
+	// Read by the workers without the park lock.
+	_Atomic(bool) halt;
 } executor_t;
 
+daggle_error_code_t
+executor_init(executor_t* executor, const daggle_instance_options_t* options);
+
 void
-task_free(task_t* task);
+executor_destroy(executor_t* executor);
 
+// Make a task available for execution. If called from a worker of this
+// executor, the task goes to the local deque of the worker, otherwise to the
+// submission queue of the group closest to the calling thread.
 daggle_error_code_t
-executor_init(executor_t* executor);
+executor_submit(executor_t* executor, task_t* task);
 
+// Task being run by the calling thread, NULL outside of tasks.
+task_t*
+executor_get_current_task(void);
+
+// Count an execution which took the given time from creation to completion.
 void
-executor_destroy(executor_t* executor);
\ No newline at end of file
+executor_record_execution(executor_t* executor, uint64_t latency_ns);
+
+daggle_error_code_t
+executor_get_statistics(executor_t* executor,
+	daggle_executor_statistics_t* out_statistics);
+
+// The worker must exist.
+daggle_error_code_t
+executor_get_worker_statistics(executor_t* executor, uint64_t worker,
+	daggle_worker_statistics_t* out_statistics);
+
+// Write the tasks recorded by the workers as a Chrome trace event JSON object.
+void
+executor_write_trace(executor_t* executor, FILE* stream);
+
+// Forget the tasks recorded so far.
+void
+executor_clear_trace(executor_t* executor);
+
+// Wait until the completion is signaled. Workers of the executor keep running
+// tasks while waiting, so waiting from within a task can't starve the pool.
+void
+executor_wait(executor_t* executor, completion_t* completion);
+
+// Wait like executor_wait, up to the timeout. A task run meanwhile may take
+// the wait past it. Returns false if the timeout expired before the
+// completion was signaled.
+bool
+executor_wait_for(executor_t* executor, completion_t* completion,
+	uint64_t timeout_ns);
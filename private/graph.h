@@ -1,8 +1,11 @@
 #pragma once
 
+#include "execution_context.h"
 #include "instance.h"
 #include "node.h"
+#include "utility/arena.h"
 #include "utility/dynamic_array.h"
+#include "utility/histogram.h"
 
 #include <daggle/daggle.h>
 
@@ -10,5 +13,45 @@ typedef struct graph_s {
 	dynamic_array_t nodes;
 	instance_t* instance;
 	node_t* owner;
-	bool locked;
-} graph_t;
\ No newline at end of file
+
+	// Number of executions in flight. The structure of the graph and the
+	// parameters can't be changed while there are any.
+	_Atomic(uint32_t) num_executions;
+
+	// Incremented whenever the nodes, ports or links change. Plans built
+	// from an older revision are rebuilt before running.
+	uint64_t revision;
+
+	// Number of port and node slots handed out, every port and node has its
+	// own.
+	uint64_t num_port_slots;
+	uint64_t num_node_slots;
+
+	// Used when executing without a context, and outside of executions.
+	execution_context_t default_context;
+
+	// Nodes and ports are allocated from the arena in creation order, and
+	// freed with the graph. Removed ones are kept for reuse in the lists,
+	// linked through their first bytes.
+	arena_t arena;
+	void* free_nodes;
+	void* free_ports;
+
+	// Time from the start of each run of the graph to the end of its last
+	// task, recorded by the thread finishing it.
+	histogram_t execution_latency;
+} graph_t;
+
+// NULL if it can't be allocated.
+node_t*
+graph_alloc_node(graph_t* graph);
+
+void
+graph_release_node(graph_t* graph, node_t* node);
+
+// NULL if it can't be allocated.
+port_t*
+graph_alloc_port(graph_t* graph);
+
+void
+graph_release_port(graph_t* graph, port_t* port);
\ No newline at end of file
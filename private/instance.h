@@ -1,11 +1,26 @@
 #pragma once
 
+#include "atom_table.h"
 #include "executor.h"
+#include "memo_cache.h"
 #include "plugin_manager.h"
 
 #include <daggle/daggle.h>
 
 typedef struct instance_s {
+	// Names of node types, data types and ports. Outlives everything else.
+	atom_table_t atoms;
+
 	plugin_manager_t plugin_manager;
 	executor_t executor;
+
+	// Run only the nodes affected by changes, see daggle_instance_options_t.
+	bool incremental_execution;
+
+	// Free outputs as soon as every linked input is done with them, unless
+	// they are kept for the next execution.
+	bool release_consumed_values;
+
+	// Outputs of memoized nodes.
+	memo_cache_t memo_cache;
 } instance_t;
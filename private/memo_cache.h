@@ -0,0 +1,88 @@
+#pragma once
+
+#include "disk_cache.h"
+#include "execution_context.h"
+#include "pthread.h"
+#include "resource_container.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+struct node_s;
+
+// Copy of an output value of a memoized node.
+typedef struct memo_output_s {
+	name_with_hash_t name_hash;
+	type_info_t* info;
+	void* data;
+} memo_output_t;
+
+typedef struct memo_entry_s {
+	uint64_t key;
+	node_info_t* node_info;
+
+	memo_output_t* outputs;
+	uint64_t num_outputs;
+
+	// Next entry in the same bucket.
+	struct memo_entry_s* chain;
+
+	// Neighbours in the recency list, the most recently used first.
+	struct memo_entry_s* newer;
+	struct memo_entry_s* older;
+} memo_entry_t;
+
+// Outputs of memoized nodes keyed by the hash of the node type, parameters and
+// input values, dropping the least recently used beyond the capacity. Misses
+// fall back to the directory of the disk cache, if there is one.
+typedef struct memo_cache_s {
+	daggle_instance_h instance;
+
+	pthread_mutex_t lock;
+
+	// Number of buckets is a power of two, at least the capacity.
+	memo_entry_t** buckets;
+	uint64_t num_buckets;
+
+	memo_entry_t* newest;
+	memo_entry_t* oldest;
+	uint64_t num_entries;
+	uint64_t capacity;
+
+	disk_cache_t disk;
+
+	_Atomic(uint64_t) hits;
+	_Atomic(uint64_t) misses;
+	_Atomic(uint64_t) evictions;
+} memo_cache_t;
+
+// Without a capacity and a directory in the options, the cache is disabled.
+daggle_error_code_t
+memo_cache_init(daggle_instance_h instance,
+	const daggle_instance_options_t* options, memo_cache_t* cache);
+
+void
+memo_cache_destroy(memo_cache_t* cache);
+
+bool
+memo_cache_is_enabled(const memo_cache_t* cache);
+
+// Hash the type, parameters and input values of a node as seen in a context.
+// The order of the ports does not matter.
+uint64_t
+memo_cache_compute_key(struct node_s* node, execution_context_t* context);
+
+// Set the outputs of the node in the context to copies of the cached ones,
+// from memory or from the directory. Returns false and counts a miss if there
+// are none.
+bool
+memo_cache_load(memo_cache_t* cache, uint64_t key, struct node_s* node,
+	execution_context_t* context);
+
+// Cache copies of the outputs of the node in the context, in memory and in the
+// directory.
+void
+memo_cache_store(memo_cache_t* cache, uint64_t key, struct node_s* node,
+	execution_context_t* context);
@@ -7,11 +7,34 @@
 
 typedef struct node_s {
 	node_info_t* info;
+
+	// Pointers to the ports, which are allocated from the arena of the graph,
+	// so handles stay valid when other ports are declared or removed.
 	dynamic_array_t ports;
+
+	// Pointers to the ports indexed by their id, NULL for removed ones. Ids are
+	// not reused, the next port gets the length as its id.
+	dynamic_array_t ports_by_id;
 	daggle_node_task_fn instance_task;
 
 	daggle_graph_h graph;
 
+	// Position of the node in the nodes of its graph.
+	uint64_t index;
+
+	// State of the node in the execution contexts is stored at this slot.
+	uint64_t slot;
+
+	// Incremented whenever a parameter, a default input value or a link of an
+	// input changes. Contexts which last ran an older version run it again.
+	uint64_t version;
+
+	// Run on every execution, even if nothing it depends on has changed.
+	bool is_volatile;
+
+	// Outputs may be reused from the memoization cache of the instance.
+	bool is_memoized;
+
 	void* custom_context;
 	daggle_node_context_free_fn custom_context_destructor;
 } node_t;
@@ -19,14 +42,32 @@ typedef struct node_s {
 daggle_error_code_t
 node_create(daggle_graph_h graph, const char* type, node_t** out_node);
 
+// Disconnect the node from the rest of the graph and free it.
 void
 node_free(node_t* node);
 
+// Free what the node holds outside of the arena of the graph, without
+// touching the nodes it is linked to. For freeing the whole graph.
+void
+node_destroy(node_t* node);
+
 port_t*
 node_get_port_by_name(node_t* node, const char* port);
 
+// Compares the name by address, the atom must be interned by the instance.
+port_t*
+node_get_port_by_atom(node_t* node, const char* atom);
+
 port_t*
 node_get_port_by_index(node_t* node, uint64_t index);
 
+// NULL if the node has no port with the id.
+port_t*
+node_get_port_by_id(node_t* node, daggle_port_id_t id);
+
+// Add a port allocated with graph_alloc_port and give it the next id.
+daggle_error_code_t
+node_add_port(node_t* node, port_t* port);
+
 void
 node_compute_declarations(node_t* node);
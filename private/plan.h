@@ -0,0 +1,83 @@
+#pragma once
+
+#include "execution_context.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "task.h"
+
+#include <daggle/daggle.h>
+
+struct graph_s;
+
+// Tasks of every node of a graph, wired up once and reused by every run. The
+// dependants of all tasks are stored back to back, and the dependency counts
+// are kept from the build, so a run only resets the counters of the tasks.
+// When executing incrementally, a run only schedules the tasks of the nodes
+// which are dirty in the context and the nodes depending on them.
+typedef struct plan_s {
+	struct graph_s* graph;
+	execution_context_t* context;
+
+	// Revision of the graph the tasks were built from.
+	uint64_t revision;
+
+	// One task per node, in the order of the nodes of the graph.
+	task_t* tasks;
+	uint64_t num_tasks;
+
+	// The dependants of task i are dependants[dependant_offsets[i]] up to
+	// dependant_offsets[i + 1], sorted by descending priority.
+	uint64_t* dependant_offsets;
+	task_t** dependants;
+
+	// Number of dependencies of each task, excluding the master task.
+	uint64_t* num_dependencies;
+
+	// Every task, dependencies before their dependants.
+	task_t** order;
+
+	// Scheduled tasks of the current run without scheduled dependencies,
+	// sorted by descending priority.
+	task_t** roots;
+	uint64_t num_roots;
+
+	// Scheduled tasks of the current run without dependants, which the sink
+	// depends on.
+	uint64_t num_leaves;
+
+	// Number of tasks scheduled in the current run.
+	uint64_t num_scheduled;
+
+	// Freed by the master task of its only run, see plan_taskify.
+	bool is_transient;
+
+	// Set from the start of a run until its master task is disposed.
+	_Atomic(bool) executing;
+
+	// Monotonic time the current run started, for the latency of the graph.
+	uint64_t started_ns;
+} plan_t;
+
+void
+plan_init(struct graph_s* graph, execution_context_t* context, plan_t* plan);
+
+void
+plan_destroy(plan_t* plan);
+
+// Build the tasks from the current structure of the graph. Fails with
+// DAGGLE_ERROR_OBJECT_LOCKED while the context is executing.
+daggle_error_code_t
+plan_compile(plan_t* plan);
+
+// Claim the context and create the master task of a run of the plan. The
+// tasks are rebuilt first if the graph has changed since they were built. The
+// master and the sink are the only tasks allocated per run, the master
+// completes right away if no node has to run.
+daggle_error_code_t
+plan_instantiate(plan_t* plan, task_t** out_task);
+
+// Create the task graph of a single run of a graph, through a plan which is
+// freed once the run has finished.
+daggle_error_code_t
+plan_taskify(struct graph_s* graph, execution_context_t* context,
+	task_t** out_task);
@@ -8,15 +8,18 @@
 
 #include <daggle/daggle.h>
 
+struct execution_context_s;
+
 typedef struct port_variant_output_s {
 	dynamic_array_t links;
-	_Atomic(uint32_t) num_pending_accesses;
 } port_variant_output_t;
 
 typedef struct port_variant_input_s {
 	daggle_port_h link;
 	daggle_input_behavior_t behavior;
-	bool has_spent_access;
+
+	// Position of the input in the links of the linked output.
+	uint64_t link_index;
 } port_variant_input_t;
 
 typedef struct port_variant_parameter_s {
@@ -25,8 +28,13 @@ typedef struct port_variant_parameter_s {
 typedef struct port_s {
 	name_with_hash_t name_hash;
 
-	// Stores the data and type info
+	// Index of the port in the ports of the owner by id.
+	daggle_port_id_t id;
+
+	// Parameter values and default input values. Output values and the access
+	// state live in the execution contexts, at the slot of the port.
 	data_container_t value;
+	uint64_t slot;
 
 	// Is the port input, output or parameter.
 	daggle_port_variant_t port_variant;
@@ -51,3 +59,14 @@ port_init(daggle_node_h node, const char* name, daggle_port_variant_t variant,
 
 void
 port_destroy(port_t* port);
+
+// Free what the port holds without disconnecting it, for when every port it
+// is linked to goes too.
+void
+port_release(port_t* port);
+
+// Container holding the value of a port in a context. Linked inputs see the
+// value of the output, unlinked ones the value set for the context, or the
+// default value. NULL if the context can't make room for the port.
+data_container_t*
+port_get_container(port_t* port, struct execution_context_s* context);
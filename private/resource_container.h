@@ -1,5 +1,9 @@
 #pragma once
 
+#include "pthread.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "stdint.h"
 #include "utility/dynamic_array.h"
 
 #include <daggle/daggle.h>
@@ -12,6 +16,10 @@ typedef struct name_with_hash_s {
 typedef struct node_info_s {
 	name_with_hash_t name_hash;
 	daggle_node_declare_fn declare;
+
+	// Moving average of the run time of the node task, used to prioritize
+	// the critical path. Zero until the node type has run.
+	_Atomic(uint64_t) average_duration_ns;
 } node_info_t;
 
 // TODO: conversion functions T -> U and K<T> -> K<U>
@@ -27,11 +35,60 @@ typedef struct type_info_s {
 
 	daggle_data_serialize_fn serializer;
 	daggle_data_deserialize_fn deserializer;
+
+	// NULL if the serialized bytes are hashed instead.
+	daggle_data_hash_fn hasher;
+
+	// Layout declared by the plugin, 0 if unknown.
+	uint64_t size;
+	uint64_t alignment;
+	bool is_trivially_copyable;
+
+	// Values are stored in the data containers themselves when set as
+	// scalars or copied.
+	bool is_inline;
+
+	// Values are reference counted, and shared by the consumers.
+	bool is_shared;
+
+	// Released values kept for producers to overwrite, instead of freed, up
+	// to a total size measured by the sizer. The limit is 0 unless the plugin
+	// asked for a pool.
+	pthread_mutex_t pool_lock;
+	dynamic_array_t pool;
+	daggle_data_size_fn pool_sizer;
+	uint64_t pool_bytes;
+	uint64_t pool_max_bytes;
 } type_info_t;
 
+// Value kept in the pool of a type, with its size as measured when released.
+typedef struct type_pool_entry_s {
+	void* data;
+	uint64_t size;
+} type_pool_entry_t;
+
+// Open addressing index of items by the hash of their name, probing linearly.
+// The slots point to the items, NULL if empty.
+typedef struct name_hash_index_s {
+	void** slots;
+
+	// Power of two, at least twice the number of items. 0 until the first
+	// item is added.
+	uint64_t num_slots;
+	uint64_t num_items;
+
+	// Offset of the name_with_hash_t member in the items.
+	uint64_t offset;
+} name_hash_index_t;
+
 typedef struct resource_container_s {
-	dynamic_array_t nodes; // node_info_t[]
-	dynamic_array_t types; // type_info_t[]
+	// The infos are allocated one by one, so the pointers held by nodes,
+	// values and type handles stay valid when more are registered.
+	dynamic_array_t nodes; // node_info_t*[]
+	dynamic_array_t types; // type_info_t*[]
+
+	name_hash_index_t node_index;
+	name_hash_index_t type_index;
 } resource_container_t;
 
 void
@@ -48,6 +105,30 @@ daggle_error_code_t
 resource_container_get_node(resource_container_t* resource_container,
 	const char* type, node_info_t** out_info);
 
+// Hash data of the type, including the name of the type.
+uint64_t
+type_info_hash_data(type_info_t* info, daggle_instance_h instance,
+	const void* data);
+
+// Keep a value no longer held by anything in the pool of the type, or free it
+// if it doesn't fit in the pool, or there is none.
+void
+type_info_release_data(type_info_t* info, daggle_instance_h instance,
+	void* data);
+
+// A released value of the type owned by the caller, NULL if there is none.
+void*
+type_info_recycle_data(type_info_t* info);
+
+// Free the values kept in the pools of the types.
+void
+resource_container_drain_pools(resource_container_t* resource_container,
+	daggle_instance_h instance);
+
+// Fold a measured run time into the average of the node type.
+void
+node_info_record_duration(node_info_t* info, uint64_t duration_ns);
+
 daggle_error_code_t
 daggle_plugin_register_node(daggle_instance_h instance,
 	const char* type, daggle_node_declare_fn declare);
@@ -56,4 +137,4 @@ daggle_error_code_t
 daggle_plugin_register_type(daggle_instance_h instance,
 	const char* type, daggle_data_clone_fn cloner, daggle_data_free_fn freer,
 	daggle_data_serialize_fn serializer,
-	daggle_data_deserialize_fn deserializer);
\ No newline at end of file
+	daggle_data_deserialize_fn deserializer, daggle_data_hash_fn hasher);
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "resource_container.h"
+#include "stdatomic.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+// Value of a shared type, held by any number of ports and node tasks at once.
+// It is immutable while there is more than one reference, and freed with the
+// last one.
+typedef struct shared_value_s {
+	_Atomic(uint64_t) num_references;
+
+	type_info_t* info;
+	daggle_instance_h instance;
+	void* data;
+} shared_value_t;
+
+// Takes ownership of the data, with one reference. NULL if it can't be
+// allocated, the data is left to the caller then.
+shared_value_t*
+shared_value_create(daggle_instance_h instance, type_info_t* info,
+	void* data);
+
+void
+shared_value_retain(shared_value_t* value);
+
+void
+shared_value_release(shared_value_t* value);
+
+// Give up a reference for data owned by the caller: the data itself if it
+// was the last reference, otherwise a copy.
+void*
+shared_value_take(shared_value_t* value);
+
+// Data which may be modified in place through the reference. A value with
+// other references is copied into a new one, which replaces the reference.
+daggle_error_code_t
+shared_value_make_mutable(shared_value_t** value, void** out_data);
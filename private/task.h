@@ -0,0 +1,147 @@
+#pragma once
+
+#include "execution.h"
+#include "execution_context.h"
+#include "stdalign.h"
+#include "stdatomic.h"
+#include "utility/closure.h"
+#include "utility/dynamic_array.h"
+
+#include <daggle/daggle.h>
+
+// Dependants stored in the task itself, more spill to the heap. Chosen so the
+// fields before the counters fill exactly two cache lines.
+#define TASK_INLINE_DEPENDANTS 2
+
+struct task_pool_s;
+
+typedef struct task_s {
+	void_closure_t work;
+
+	struct task_s* head; // Parent of the subgraph this is a part of
+	struct task_s* tail; // Tail of this' own subgraph
+	uint64_t num_subtasks; // number of subtasks (incl. sink)
+
+	// Set on root tasks submitted for execution, completed when the root is
+	// freed. Subtasks inherit it from their head when they run.
+	execution_t* execution;
+
+	// Pool the task was allocated from. NULL for the tasks of plans, which
+	// are owned by the plan and never freed on their own.
+	struct task_pool_s* pool;
+
+	// Link used while the task is in a free list or a task queue.
+	_Atomic(struct task_s*) next;
+
+	// Node task of tasks created with daggle_task_create, called by work.
+	daggle_node_task_fn node_function;
+	daggle_node_task_dispose_fn node_dispose;
+	void* node_context;
+
+	// Points to inline_dependants until there are more than fit in there.
+	// Lists borrowed from a plan have no capacity and are copied on change.
+	// Dependants of prioritized tasks are sorted by descending priority.
+	struct task_s** dependants;
+	uint32_t num_dependants;
+	uint32_t dependants_capacity;
+	struct task_s* inline_dependants[TASK_INLINE_DEPENDANTS];
+
+	// The counters are decremented by whichever workers finish the subtasks
+	// and dependencies, keep them on separate cache lines from each other and
+	// from the fields read by the worker running the task.
+	alignas(64) _Atomic(uint64_t) num_pending_subtasks; // this + subtasks
+	alignas(64) _Atomic(uint64_t) num_pending_dependencies;
+
+	// Estimated time from the start of this task to the end of the graph.
+	// Only written while the task graph is built.
+	uint64_t priority;
+
+	// Context the ports are accessed through. Set on the master tasks of
+	// graphs, other tasks inherit it from their head when they run.
+	execution_context_t* execution_context;
+
+	// Name of the task in traces, NULL if unnamed. Not owned.
+	const char* id;
+
+	// When the task was made ready to run, only kept while tracing.
+	uint64_t ready_ns;
+} task_t;
+
+// Cache-line aligned task slabs owned by one thread. Only the owner allocates.
+// Tasks freed by other threads are collected into batches, which are pushed
+// onto the remote list of the owning pool in one go.
+typedef struct task_pool_s {
+	// Free tasks, only accessed by the owner.
+	task_t* free_list;
+
+	// Allocated slabs, freed with the pool.
+	dynamic_array_t slabs;
+
+	// Batch of tasks freed by the owner of this pool into another pool.
+	struct task_pool_s* batch_pool;
+	task_t* batch_head;
+	task_t* batch_tail;
+	uint64_t batch_length;
+
+	// Tasks returned by other threads, taken by the owner all at once.
+	alignas(64) _Atomic(task_t*) remote_free_list;
+} task_pool_t;
+
+void
+task_pool_init(task_pool_t* pool);
+
+// Free the slabs. Every task of the pool must have been returned to it.
+void
+task_pool_destroy(task_pool_t* pool);
+
+// Only the owner of the pool may allocate. The task is left uninitialized.
+task_t*
+task_pool_alloc(task_pool_t* pool);
+
+// Return a task to the pool of the calling thread, which must own it.
+void
+task_pool_free_local(task_pool_t* pool, task_t* task);
+
+// Return a task owned by another pool. Without a local pool the task is sent
+// back right away, otherwise it waits in the batch of the local pool.
+void
+task_pool_free_remote(task_pool_t* local /* nullable */, task_t* task);
+
+// Send the pending batch of the pool back to its owner.
+void
+task_pool_flush(task_pool_t* pool);
+
+// Initialize a task without work. The pool is left as is.
+void
+task_init(task_t* task);
+
+// Allocate and initialize a task without work from the pool of the calling
+// thread. Threads outside of the executors share a locked pool.
+task_t*
+task_alloc(void);
+
+// Dispose and free a task, completing its execution if it is a root task.
+void
+task_free(task_t* task);
+
+daggle_error_code_t
+task_add_dependant(task_t* task, task_t* dependant);
+
+// Move the dependants of a task to another task without any.
+void
+task_move_dependants(task_t* from, task_t* to);
+
+// Whether the dependant list was allocated by the task itself.
+bool
+task_owns_dependants(const task_t* task);
+
+// Make a task call a node task function, like the tasks created with
+// daggle_task_create do.
+void
+task_set_node_task(task_t* task, daggle_node_task_fn work,
+	daggle_node_task_dispose_fn dispose, void* context);
+
+// Create the sink of the subgraph of a task. The sink takes over the
+// dependants of the task and frees the task once the subgraph has finished.
+task_t*
+task_create_sink(task_t* task);
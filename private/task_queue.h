@@ -0,0 +1,40 @@
+#pragma once
+
+#include "stdalign.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "task.h"
+
+// Unbounded queue of tasks, linked through the next field of the tasks, so
+// enqueueing never allocates. Producers are lock-free. Consumers take turns,
+// a consumer finding the queue in use by another one returns empty-handed
+// instead of waiting.
+typedef struct task_queue_s {
+	// Producers swap themselves in at the back.
+	alignas(64) _Atomic(task_t*) back;
+
+	// Only accessed by the consumer holding the lock.
+	alignas(64) task_t* front;
+	atomic_flag consumer_lock;
+
+	// Number of tasks enqueued and not yet dequeued.
+	_Atomic(uint64_t) size;
+
+	// Placeholder keeping the queue non-empty, so producers never touch the
+	// front.
+	task_t stub;
+} task_queue_t;
+
+void
+task_queue_init(task_queue_t* queue);
+
+void
+task_queue_enqueue(task_queue_t* queue, task_t* task);
+
+// Returns NULL if the queue is empty, in use by another consumer, or a
+// producer is between its two steps.
+task_t*
+task_queue_try_dequeue(task_queue_t* queue);
+
+bool
+task_queue_is_empty(task_queue_t* queue);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "stdint.h"
+#include "stdio.h"
+
+#include <daggle/daggle.h>
+
+// One run of a task.
+typedef struct trace_event_s {
+	const char* id;
+
+	// Identify the task and the head of its subgraph. Tasks are reused, so
+	// these are only unique among the tasks alive at the same time.
+	const void* task;
+	const void* parent;
+
+	// When the task became ready, started and finished running.
+	uint64_t ready_ns;
+	uint64_t start_ns;
+	uint64_t end_ns;
+} trace_event_t;
+
+// Ring of the most recent runs of the tasks of one worker. Only the worker
+// records, so recording takes no locks. Readers on other threads may see the
+// oldest events being overwritten, they are exact between executions.
+typedef struct trace_buffer_s {
+	trace_event_t* events;
+	uint64_t capacity;
+
+	// Events ever recorded, the last capacity of them are kept.
+	_Atomic(uint64_t) num_recorded;
+
+	// Events recorded before the last clear, which are no longer reported.
+	_Atomic(uint64_t) num_cleared;
+} trace_buffer_t;
+
+// A capacity of 0 disables the buffer.
+daggle_error_code_t
+trace_buffer_init(uint64_t capacity, trace_buffer_t* buffer);
+
+void
+trace_buffer_destroy(trace_buffer_t* buffer);
+
+bool
+trace_buffer_is_enabled(const trace_buffer_t* buffer);
+
+// Only called by the owning worker.
+void
+trace_buffer_record(trace_buffer_t* buffer, const trace_event_t* event);
+
+void
+trace_buffer_clear(trace_buffer_t* buffer);
+
+// Write the events as comma-separated Chrome trace events on the thread tid,
+// with the timestamps relative to epoch_ns. The first written event is not
+// preceded by a comma if is_first is set, which is then cleared.
+void
+trace_buffer_write_chrome(trace_buffer_t* buffer, uint64_t tid,
+	uint64_t epoch_ns, FILE* stream, bool* is_first);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "pthread.h"
+#include "stdalign.h"
+#include "stdatomic.h"
+#include "stddef.h"
+#include "stdint.h"
+
+typedef struct arena_chunk_s {
+	struct arena_chunk_s* next;
+	uint64_t capacity;
+	_Atomic(uint64_t) used;
+	alignas(max_align_t) unsigned char data[];
+} arena_chunk_t;
+
+// Bump allocator. Allocations are laid out one after another in chunks of
+// growing size, and only freed all at once when the arena is reset or
+// destroyed.
+typedef struct arena_s {
+	// The newest chunk first, allocations are taken from it.
+	_Atomic(arena_chunk_t*) chunks;
+
+	// Capacity of the next chunk.
+	uint64_t next_capacity;
+} arena_t;
+
+void
+arena_init(arena_t* arena);
+
+void
+arena_destroy(arena_t* arena);
+
+// Free every allocation at once. The newest chunk, the largest, is kept for
+// the allocations to come.
+void
+arena_reset(arena_t* arena);
+
+// Memory aligned for any type, NULL if it can't be allocated.
+void*
+arena_alloc(arena_t* arena, uint64_t size);
+
+// Memory aligned to a power of two, NULL if it can't be allocated.
+void*
+arena_alloc_aligned(arena_t* arena, uint64_t size, uint64_t alignment);
+
+// Like arena_alloc_aligned, safe to call from many threads at once. Space is
+// claimed from the newest chunk without locking, the lock is only taken to add
+// a chunk when it is full. Must not be mixed with the other allocations.
+void*
+arena_alloc_concurrent(arena_t* arena, pthread_mutex_t* lock, uint64_t size,
+	uint64_t alignment);
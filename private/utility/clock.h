@@ -0,0 +1,7 @@
+#pragma once
+
+#include "stdint.h"
+
+// Nanoseconds on the monotonic clock, from an unspecified starting point.
+uint64_t
+clock_now_ns(void);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pthread.h"
+#include "stdatomic.h"
+#include "stdbool.h"
+#include "stdint.h"
+
+// One-shot event. Waiters sleep on a condition variable until it is signaled.
+typedef struct completion_s {
+	pthread_mutex_t lock;
+	pthread_cond_t condition;
+	_Atomic(bool) done;
+} completion_t;
+
+void
+completion_init(completion_t* completion);
+
+void
+completion_destroy(completion_t* completion);
+
+void
+completion_signal(completion_t* completion);
+
+bool
+completion_poll(completion_t* completion);
+
+void
+completion_wait(completion_t* completion);
+
+// Returns false if the timeout expired before the completion was signaled.
+bool
+completion_wait_for(completion_t* completion, uint64_t timeout_ns);
@@ -6,4 +6,11 @@ uint32_t
 fnv1a_32(const char* str);
 
 uint64_t
-fnv1a_64(const char* str);
\ No newline at end of file
+fnv1a_64(const char* str);
+
+uint64_t
+fnv1a_64_bytes(const void* bytes, uint64_t len);
+
+// Mix a value into a hash, so that the order of the values matters.
+uint64_t
+hash_combine_64(uint64_t hash, uint64_t value);
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "stdatomic.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+// Each power of two is split into this many buckets, so a recorded value is
+// known to within an eighth of it. Values below it get a bucket each.
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#define HISTOGRAM_SUB_BUCKETS (1ull << HISTOGRAM_SUB_BUCKET_BITS)
+
+// Enough buckets for any 64-bit value.
+#define HISTOGRAM_NUM_BUCKETS                                                  \
+	((64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+// Log-linear histogram of durations in the style of HDR histograms. Recording
+// is lock-free, reads are not atomic as a whole but every value read has been
+// recorded.
+typedef struct histogram_s {
+	_Atomic(uint64_t) count;
+	_Atomic(uint64_t) sum;
+	_Atomic(uint64_t) max;
+	_Atomic(uint64_t) buckets[HISTOGRAM_NUM_BUCKETS];
+} histogram_t;
+
+// Plain copy of histograms, merged for reading.
+typedef struct histogram_snapshot_s {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t buckets[HISTOGRAM_NUM_BUCKETS];
+} histogram_snapshot_t;
+
+void
+histogram_init(histogram_t* histogram);
+
+// Safe to call from many threads at once.
+void
+histogram_record(histogram_t* histogram, uint64_t value);
+
+// Cheaper, for histograms only ever written by one thread, with plain stores
+// like the other counters of a worker.
+void
+histogram_record_exclusive(histogram_t* histogram, uint64_t value);
+
+// Empty snapshot, to add histograms to.
+void
+histogram_snapshot_init(histogram_snapshot_t* snapshot);
+
+void
+histogram_snapshot_add(histogram_snapshot_t* snapshot,
+	const histogram_t* histogram);
+
+// Smallest value at or above the quantile q of the recorded values, as the
+// upper end of its bucket.
+uint64_t
+histogram_snapshot_quantile(const histogram_snapshot_t* snapshot, double q);
+
+void
+histogram_snapshot_summarize(const histogram_snapshot_t* snapshot,
+	daggle_duration_summary_t* out_summary);
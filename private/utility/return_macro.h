@@ -15,6 +15,8 @@ static const char* daggle_error_code_strings[] = {
 	"MEMORY_ALLOCATION",
 	"INCORRECT_PORT_VARIANT",
 	"OBJECT_LOCKED",
+	"TIMEOUT",
+	"CANCELLED",
 };
 
 #ifdef DAGGLE_ENABLE_RETURN_STATUS_ERROR_LOGS
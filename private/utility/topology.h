@@ -0,0 +1,32 @@
+#pragma once
+
+#include "pthread.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+// Node of CPU ids which don't belong to a CPU.
+#define TOPOLOGY_NO_NODE UINT64_MAX
+
+// Number of online CPUs, at least 1.
+uint64_t
+topology_get_num_cpus(void);
+
+// One past the highest id of a CPU which may come online, at least 1. Ids
+// may be sparse, so this can be more than the number of CPUs. CPUs with
+// larger ids can't be pinned to.
+uint64_t
+topology_get_cpu_id_limit(void);
+
+// NUMA node of a CPU. Returns 0 if the node can't be determined, and
+// TOPOLOGY_NO_NODE if there is no CPU with the id.
+uint64_t
+topology_get_cpu_node(uint64_t cpu);
+
+// CPU the calling thread is running on. Returns 0 if unknown.
+uint64_t
+topology_get_current_cpu(void);
+
+// Restrict a thread to run only on the given CPUs.
+daggle_error_code_t
+topology_pin_thread(pthread_t thread, const uint64_t* cpus, uint64_t num_cpus);
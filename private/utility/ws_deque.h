@@ -0,0 +1,49 @@
+#pragma once
+
+#include "stdalign.h"
+#include "stdatomic.h"
+#include "stdint.h"
+
+#include <daggle/daggle.h>
+
+// Chase-Lev work-stealing deque, following the C11 formulation by Le et al.
+// The owning thread pushes and pops at the bottom (LIFO), while other threads
+// steal from the top (FIFO). The buffer grows on demand; retired buffers are
+// kept alive until the deque is destroyed, since thieves may still read them.
+
+typedef struct ws_deque_buffer_s {
+	uint64_t capacity; // Always a power of two.
+	struct ws_deque_buffer_s* retired; // Previous, smaller buffer.
+	_Atomic(void*) items[];
+} ws_deque_buffer_t;
+
+typedef struct ws_deque_s {
+	// Top and bottom are written by different threads, keep them apart.
+	alignas(64) _Atomic(int64_t) top;
+	alignas(64) _Atomic(int64_t) bottom;
+	_Atomic(ws_deque_buffer_t*) buffer;
+} ws_deque_t;
+
+// Capacity is rounded up to a power of two.
+daggle_error_code_t
+ws_deque_init(uint64_t capacity, ws_deque_t* deque);
+
+void
+ws_deque_destroy(ws_deque_t* deque);
+
+// Must only be called by the owner of the deque.
+daggle_error_code_t
+ws_deque_push(ws_deque_t* deque, void* item);
+
+// Must only be called by the owner of the deque. Returns NULL if empty.
+void*
+ws_deque_pop(ws_deque_t* deque);
+
+// May be called by any thread. Returns NULL if empty or if the steal lost a
+// race against another thief or the owner.
+void*
+ws_deque_steal(ws_deque_t* deque);
+
+// Approximate number of items, exact only when the deque is quiescent.
+int64_t
+ws_deque_size(ws_deque_t* deque);
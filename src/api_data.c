@@ -1,5 +1,6 @@
 #include "instance.h"
 #include "resource_container.h"
+#include "shared_value.h"
 #include "stdlib.h"
 #include "utility/return_macro.h"
 
@@ -42,42 +43,214 @@ daggle_data_get_type_handlers(daggle_instance_h instance, const char* type,
 }
 
 daggle_error_code_t
-daggle_data_clone(daggle_instance_h instance, const char* type, void* data,
-	void** out_data)
+daggle_data_hash(daggle_instance_h instance, const char* type,
+	const void* data, uint64_t* out_hash)
 {
 	REQUIRE_PARAMETER(instance);
 	REQUIRE_PARAMETER(type);
 	REQUIRE_PARAMETER(data);
+	REQUIRE_OUTPUT_PARAMETER(out_hash);
 
-	LOG_FMT_COND_DEBUG("Clone %s", type);
+	instance_t* instance_impl = instance;
 
-	daggle_data_clone_fn cloner;
-	RETURN_IF_ERROR(daggle_data_get_type_handlers(instance, type, &cloner, NULL,
-		NULL, NULL));
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&instance_impl->plugin_manager.res, type, &info));
 
-	cloner(instance, data, out_data);
+	*out_hash = type_info_hash_data(info, instance, data);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
-daggle_data_free(daggle_instance_h instance, const char* type, void* data)
+daggle_data_get_type(daggle_instance_h instance, const char* type,
+	daggle_type_h* out_type)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_OUTPUT_PARAMETER(out_type);
+
+	instance_t* instance_impl = instance;
+
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&instance_impl->plugin_manager.res, type, &info));
+
+	*out_type = info;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_data_get_type_name(daggle_type_h type, const char** out_type_name)
+{
+	REQUIRE_PARAMETER(type);
+	REQUIRE_OUTPUT_PARAMETER(out_type_name);
+
+	type_info_t* info = type;
+	*out_type_name = info->name_hash.name;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_data_clone_typed(daggle_instance_h instance, daggle_type_h type,
+	void* data, void** out_data)
 {
 	REQUIRE_PARAMETER(instance);
 	REQUIRE_PARAMETER(type);
 	REQUIRE_PARAMETER(data);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
 
-	LOG_FMT_COND_DEBUG("Free %s", type);
+	type_info_t* info = type;
 
-	daggle_data_free_fn destructor;
-	RETURN_IF_ERROR(daggle_data_get_type_handlers(instance, type, NULL,
-		&destructor, NULL, NULL));
+	LOG_FMT_COND_DEBUG("Clone %s", info->name_hash.name);
 
-	destructor(instance, data);
+	info->cloner(instance, data, out_data);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
+daggle_error_code_t
+daggle_data_free_typed(daggle_instance_h instance, daggle_type_h type,
+	void* data)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_PARAMETER(data);
+
+	type_info_t* info = type;
+
+	LOG_FMT_COND_DEBUG("Free %s", info->name_hash.name);
+
+	info->freer(instance, data);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_data_recycle(daggle_instance_h instance, daggle_type_h type,
+	void** out_data)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
+
+	*out_data = type_info_recycle_data(type);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_value_create(daggle_instance_h instance, daggle_type_h type,
+	void* data, daggle_value_h* out_value)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_PARAMETER(data);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	shared_value_t* value = shared_value_create(instance, type, data);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(value);
+
+	*out_value = value;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_value_retain(daggle_value_h value)
+{
+	REQUIRE_PARAMETER(value);
+
+	shared_value_retain(value);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_value_release(daggle_value_h value)
+{
+	REQUIRE_PARAMETER(value);
+
+	shared_value_release(value);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_value_get_type(daggle_value_h value, daggle_type_h* out_type)
+{
+	REQUIRE_PARAMETER(value);
+	REQUIRE_OUTPUT_PARAMETER(out_type);
+
+	shared_value_t* value_impl = value;
+	*out_type = value_impl->info;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_value_get_data(daggle_value_h value, void** out_data)
+{
+	REQUIRE_PARAMETER(value);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
+
+	shared_value_t* value_impl = value;
+	*out_data = value_impl->data;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_value_make_mutable(daggle_value_h* value, void** out_data)
+{
+	REQUIRE_PARAMETER(value);
+	REQUIRE_PARAMETER(*value);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
+
+	RETURN_STATUS(
+		shared_value_make_mutable((shared_value_t**)value, out_data));
+}
+
+daggle_error_code_t
+daggle_value_take(daggle_value_h value, void** out_data)
+{
+	REQUIRE_PARAMETER(value);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
+
+	*out_data = shared_value_take(value);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_data_clone(daggle_instance_h instance, const char* type, void* data,
+	void** out_data)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_PARAMETER(data);
+
+	daggle_type_h handle;
+	RETURN_IF_ERROR(daggle_data_get_type(instance, type, &handle));
+
+	RETURN_STATUS(daggle_data_clone_typed(instance, handle, data, out_data));
+}
+
+daggle_error_code_t
+daggle_data_free(daggle_instance_h instance, const char* type, void* data)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_PARAMETER(data);
+
+	daggle_type_h handle;
+	RETURN_IF_ERROR(daggle_data_get_type(instance, type, &handle));
+
+	RETURN_STATUS(daggle_data_free_typed(instance, handle, data));
+}
+
 daggle_error_code_t
 daggle_data_serialize(daggle_instance_h instance, const char* type,
 	const void* data, unsigned char** out_bin, uint64_t* out_len)
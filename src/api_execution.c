@@ -1,245 +1,359 @@
+#include "execution.h"
 #include "executor.h"
 #include "graph.h"
 #include "instance.h"
-#include "node.h"
-#include "ports.h"
+#include "plan.h"
 #include "stdatomic.h"
 #include "stdbool.h"
 #include "stdio.h"
 #include "stdlib.h"
-#include "utility/closure.h"
-#include "utility/dynamic_array.h"
 #include "utility/log_macro.h"
 #include "utility/return_macro.h"
-#include "utility/thread_safe_linked_queue.h"
 
 #include <daggle/daggle.h>
 
-void
-prv_graph_master_task_function(void* context)
+daggle_error_code_t
+daggle_graph_taskify(daggle_graph_h graph, daggle_task_h* out_task)
 {
-	ASSERT_NOT_NULL(context, "context is null");
-	LOG(LOG_TAG_INFO, "Run Graph");
+	REQUIRE_PARAMETER(graph);
+	REQUIRE_OUTPUT_PARAMETER(out_task);
+
+	graph_t* graph_impl = graph;
+
+	task_t* task;
+	RETURN_IF_ERROR(
+		plan_taskify(graph_impl, &graph_impl->default_context, &task));
+
+	*out_task = task;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
-void
-prv_graph_master_task_dispose(void* context)
+daggle_error_code_t
+daggle_graph_taskify_with_context(daggle_graph_h graph,
+	daggle_execution_context_h context, daggle_task_h* out_task)
 {
-	ASSERT_NOT_NULL(context, "context is null");
-	graph_t* graph = context;
+	REQUIRE_PARAMETER(graph);
+	REQUIRE_PARAMETER(context);
+	REQUIRE_OUTPUT_PARAMETER(out_task);
 
-	LOG(LOG_TAG_INFO, "Finish Graph");
+	execution_context_t* context_impl = context;
+	if (context_impl->graph != graph) {
+		LOG(LOG_TAG_ERROR, "The context was created for another graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	task_t* task;
+	RETURN_IF_ERROR(plan_taskify(graph, context_impl, &task));
+
+	*out_task = task;
 
-	graph->locked = false;
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_graph_execute(daggle_instance_h instance, daggle_graph_h graph)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(graph);
+
+	daggle_task_h task;
+	RETURN_IF_ERROR(daggle_graph_taskify(graph, &task));
+
+	// The context is released by the master task dispose, which is finished
+	// once the execution is.
+	RETURN_STATUS(daggle_task_execute(instance, task));
 }
 
-void
-prv_node_call_function(daggle_task_h task, void* context)
+daggle_error_code_t
+daggle_task_execute(daggle_instance_h instance, daggle_task_h task)
 {
-	node_t* node = context;
-	
-	node->instance_task(task, node->custom_context);
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(task);
+
+	daggle_execution_h execution;
+	RETURN_IF_ERROR(
+		daggle_task_execute_async(instance, task, NULL, NULL, &execution));
+
+	daggle_error_code_t error = daggle_execution_wait(execution);
+	daggle_execution_free(execution);
+
+	RETURN_STATUS(error);
 }
 
-void
-prv_node_call_dispose(void* context)
+daggle_error_code_t
+daggle_task_execute_async(daggle_instance_h instance, daggle_task_h task,
+	daggle_execution_callback_fn callback, void* user_data,
+	daggle_execution_h* out_execution)
 {
-	node_t* node = context;
-
-	// Subtract reference accesses.
-	for (uint64_t i = 0; i < node->ports.length; ++i) {
-		port_t* port = dynamic_array_at(&node->ports, i);
-		if(port->port_variant == DAGGLE_PORT_INPUT && port->variant.input.behavior == DAGGLE_INPUT_BEHAVIOR_REFERENCE && port->variant.input.link) {
-			port_t* link = port->variant.input.link;
-			atomic_fetch_sub(&link->variant.output.num_pending_accesses, 1);
-		}
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(task);
+
+	instance_t* instance_impl = instance;
+	task_t* task_impl = task;
+
+	execution_t* execution;
+	RETURN_IF_ERROR(execution_create(&instance_impl->executor, callback,
+		user_data, &execution));
+
+	task_impl->execution = execution;
+
+	daggle_error_code_t error
+		= executor_submit(&instance_impl->executor, task_impl);
+	if (error != DAGGLE_SUCCESS) {
+		// Nothing can be waiting for it, drop both references.
+		task_impl->execution = NULL;
+		execution_release(execution);
+		execution_release(execution);
+		RETURN_STATUS(error);
 	}
-	
-	if(node->custom_context_destructor) {
-		node->custom_context_destructor(node->custom_context);
+
+	// The handle keeps the execution alive even if it has already completed.
+	// Without a handle, the caller gives up its reference right away.
+	if (!out_execution) {
+		execution_release(execution);
+	} else {
+		*out_execution = execution;
 	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
-prv_nodes_taskify(graph_t* graph, daggle_task_h* out_task)
+daggle_graph_execute_async(daggle_instance_h instance, daggle_graph_h graph,
+	daggle_execution_callback_fn callback, void* user_data,
+	daggle_execution_h* out_execution)
 {
-	ASSERT_PARAMETER(graph);
-	ASSERT_OUTPUT_PARAMETER(out_task);
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(graph);
+
+	daggle_task_h task;
+	RETURN_IF_ERROR(daggle_graph_taskify(graph, &task));
+
+	RETURN_STATUS(daggle_task_execute_async(instance, task, callback,
+		user_data, out_execution));
+}
+
+daggle_error_code_t
+daggle_execution_context_create(daggle_graph_h graph,
+	daggle_execution_context_h* out_context)
+{
+	REQUIRE_PARAMETER(graph);
+	REQUIRE_OUTPUT_PARAMETER(out_context);
+
+	execution_context_t* context = malloc(sizeof *context);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(context);
 
-	dynamic_array_t* nodes = &graph->nodes;
+	execution_context_init(graph, context);
 
-	if (graph->locked) {
+	*out_context = context;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_execution_context_free(daggle_execution_context_h context)
+{
+	REQUIRE_PARAMETER(context);
+
+	execution_context_t* context_impl = context;
+
+	if (atomic_load(&context_impl->executing)) {
 		RETURN_STATUS(DAGGLE_ERROR_OBJECT_LOCKED);
 	}
 
-	if (nodes->length == 0) {
-		LOG(LOG_TAG_ERROR,
-			"At least one node must be defined to execute a graph");
+	execution_context_destroy(context_impl);
+	free(context_impl);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_execution_context_execute(daggle_instance_h instance,
+	daggle_execution_context_h context)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(context);
+
+	execution_context_t* context_impl = context;
+
+	daggle_task_h task;
+	RETURN_IF_ERROR(
+		daggle_graph_taskify_with_context(context_impl->graph, context, &task));
+
+	RETURN_STATUS(daggle_task_execute(instance, task));
+}
+
+daggle_error_code_t
+daggle_execution_context_execute_async(daggle_instance_h instance,
+	daggle_execution_context_h context, daggle_execution_callback_fn callback,
+	void* user_data, daggle_execution_h* out_execution)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(context);
+
+	execution_context_t* context_impl = context;
+
+	daggle_task_h task;
+	RETURN_IF_ERROR(
+		daggle_graph_taskify_with_context(context_impl->graph, context, &task));
+
+	RETURN_STATUS(daggle_task_execute_async(instance, task, callback,
+		user_data, out_execution));
+}
+
+daggle_error_code_t
+daggle_graph_compile(daggle_graph_h graph,
+	daggle_execution_context_h context, daggle_plan_h* out_plan)
+{
+	REQUIRE_PARAMETER(graph);
+	REQUIRE_OUTPUT_PARAMETER(out_plan);
+
+	graph_t* graph_impl = graph;
+	execution_context_t* context_impl
+		= context ? context : &graph_impl->default_context;
+
+	if (context_impl->graph != graph_impl) {
+		LOG(LOG_TAG_ERROR, "The context was created for another graph");
 		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
 	}
 
-	daggle_error_code_t error = DAGGLE_SUCCESS;
-	dynamic_array_t tasks;
-	error = dynamic_array_init(nodes->length, sizeof(task_t*), &tasks);
-	GOTO_IF_ERROR(error, node_error);
-
-	graph->locked = true;
-
-	// Create the tasks.
-	for (uint64_t i = 0; i < nodes->length; ++i) {
-		node_t** nodeelem = dynamic_array_at(nodes, i);
-		node_t* node = *nodeelem;
-
-		// TODO: move to a more appropriate location.
-		// Reset port counters.
-		for (uint64_t j = 0; j < node->ports.length; ++j) {
-			port_t* port = dynamic_array_at(&node->ports, j);
-
-			if(port->port_variant == DAGGLE_PORT_INPUT) {
-				port->variant.input.has_spent_access = false;
-			} else if(port->port_variant == DAGGLE_PORT_OUTPUT) {
-				atomic_store(&port->variant.output.num_pending_accesses, 
-					port->variant.output.links.length);
-			}
-		}
-
-		task_t* tk;
-		daggle_task_create(prv_node_call_function, prv_node_call_dispose, node,
-			(char*)node->info->name_hash.name, (daggle_task_h*)&tk);
-
-		// TODO: handle error, must task_free(tk) every initialized array
-		dynamic_array_push(&tasks, &tk);
+	plan_t* plan = malloc(sizeof *plan);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(plan);
+
+	plan_init(graph_impl, context_impl, plan);
+
+	daggle_error_code_t error = plan_compile(plan);
+	if (error != DAGGLE_SUCCESS) {
+		plan_destroy(plan);
+		free(plan);
+		RETURN_STATUS(error);
 	}
 
-	// Construct dependencies with node links.
-	for (uint64_t i = 0; i < tasks.length; ++i) {
-		task_t** tkelem = dynamic_array_at(&tasks, i);
-		task_t* tk = *tkelem;
-
-		node_t** nodeelem = dynamic_array_at(nodes, i);
-		node_t* node = *nodeelem;
-
-		// For each output port of the node.
-		for (uint64_t j = 0; j < node->ports.length; ++j) {
-			port_t* item = dynamic_array_at(&node->ports, j);
-			if (item->port_variant != DAGGLE_PORT_OUTPUT) {
-				continue;
-			}
-
-			// For each link in the port.
-			dynamic_array_t* links = &item->variant.output.links;
-			for (uint64_t j = 0; j < links->length; ++j) {
-				port_t** linkelem = dynamic_array_at(links, j);
-
-				// Get the owner node of the port.
-				node_t* owner = (*linkelem)->owner;
-
-				// Find the tark corresponding to the linked node.
-				task_t* task = NULL;
-				for (uint64_t k = 0; k < nodes->length; ++k) {
-					node_t** ndelem = dynamic_array_at(nodes, k);
-					node_t* n = *ndelem;
-
-					if (n == owner) {
-						task_t** tklm = dynamic_array_at(&tasks, k);
-						task = *tklm;
-						break;
-					}
-
-					task = NULL;
-				}
-
-				// Skip if the task was not found.
-				// i.e. A->B, where only A is executed.
-				if (!task) {
-					LOG(LOG_TAG_ERROR, "NOT FOUND");
-					continue;
-				}
-
-				error = daggle_task_depend(task, tk);
-				GOTO_IF_ERROR(error, node_error);
-			}
-		}
+	*out_plan = plan;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_plan_free(daggle_plan_h plan)
+{
+	REQUIRE_PARAMETER(plan);
+
+	plan_t* plan_impl = plan;
+
+	if (atomic_load(&plan_impl->executing)) {
+		RETURN_STATUS(DAGGLE_ERROR_OBJECT_LOCKED);
 	}
 
-	task_t* master_task = malloc(sizeof(task_t));
-	master_task->tail = NULL;
-	master_task->head = NULL;
+	plan_destroy(plan_impl);
+	free(plan_impl);
 
-	master_task->num_subtasks = 0;
-	atomic_store(&master_task->num_pending_subtasks, 1);
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
 
-	dynamic_array_init(0, sizeof(task_t*), &master_task->dependants);
-	atomic_store(&master_task->num_pending_dependencies, 0);
+daggle_error_code_t
+daggle_plan_execute(daggle_instance_h instance, daggle_plan_h plan)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(plan);
 
-	master_task->work.function = prv_graph_master_task_function;
-	master_task->work.dispose = prv_graph_master_task_dispose;
-	master_task->work.context = graph;
+	task_t* task;
+	RETURN_IF_ERROR(plan_instantiate(plan, &task));
 
-	daggle_task_add_subgraph(master_task, tasks.data, tasks.length);
-	dynamic_array_destroy(&tasks);
+	RETURN_STATUS(daggle_task_execute(instance, task));
+}
 
-	*out_task = master_task;
+daggle_error_code_t
+daggle_plan_execute_async(daggle_instance_h instance, daggle_plan_h plan,
+	daggle_execution_callback_fn callback, void* user_data,
+	daggle_execution_h* out_execution)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(plan);
+
+	task_t* task;
+	RETURN_IF_ERROR(plan_instantiate(plan, &task));
+
+	RETURN_STATUS(daggle_task_execute_async(instance, task, callback,
+		user_data, out_execution));
+}
+
+daggle_error_code_t
+daggle_execution_wait(daggle_execution_h execution)
+{
+	REQUIRE_PARAMETER(execution);
+
+	execution_t* execution_impl = execution;
+
+	executor_wait(execution_impl->executor, &execution_impl->completion);
+
+	if (atomic_load(&execution_impl->skipped)) {
+		RETURN_STATUS(DAGGLE_ERROR_CANCELLED);
+	}
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
+}
 
-node_error:
-	for (uint64_t i = 0; i <= tasks.length; ++i) {
-		task_t** tkelem = dynamic_array_at(&tasks, i);
-		task_t* tk = *tkelem;
-		task_free(tk);
+daggle_error_code_t
+daggle_execution_wait_for(daggle_execution_h execution, uint64_t timeout_ns)
+{
+	REQUIRE_PARAMETER(execution);
+
+	execution_t* execution_impl = execution;
+
+	if (!executor_wait_for(execution_impl->executor,
+			&execution_impl->completion, timeout_ns)) {
+		RETURN_STATUS(DAGGLE_ERROR_TIMEOUT);
 	}
 
-	dynamic_array_destroy(&tasks);
+	if (atomic_load(&execution_impl->skipped)) {
+		RETURN_STATUS(DAGGLE_ERROR_CANCELLED);
+	}
 
-	RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
-daggle_graph_taskify(daggle_graph_h graph, daggle_task_h* out_task)
+daggle_execution_poll(daggle_execution_h execution, bool* out_finished)
 {
-	REQUIRE_PARAMETER(graph);
-	REQUIRE_OUTPUT_PARAMETER(out_task);
+	REQUIRE_PARAMETER(execution);
+	REQUIRE_OUTPUT_PARAMETER(out_finished);
 
-	daggle_task_h task;
-	RETURN_IF_ERROR(prv_nodes_taskify(graph, &task));
+	execution_t* execution_impl = execution;
 
-	*out_task = task;
+	*out_finished = completion_poll(&execution_impl->completion);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
-daggle_graph_execute(daggle_instance_h instance, daggle_graph_h graph)
+daggle_execution_cancel(daggle_execution_h execution)
 {
-	REQUIRE_PARAMETER(instance);
-	REQUIRE_PARAMETER(graph);
+	REQUIRE_PARAMETER(execution);
 
-	daggle_task_h task;
-	daggle_graph_taskify(graph, &task);
-	daggle_task_execute(instance, task);
-	while (((graph_t*)graph)->locked) {
-	
-	}
+	execution_cancel(execution);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
-daggle_task_execute(daggle_instance_h instance, daggle_task_h task)
+daggle_execution_set_deadline(daggle_execution_h execution,
+	uint64_t timeout_ns)
 {
-	REQUIRE_PARAMETER(instance);
-	REQUIRE_PARAMETER(task);
+	REQUIRE_PARAMETER(execution);
 
-	instance_t* instance_impl = instance;
+	execution_set_deadline(execution, timeout_ns);
 
-	ts_llist_queue_enqueue(&instance_impl->executor.queue, task);
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
 
-	task_t* t = task;
+daggle_error_code_t
+daggle_execution_free(daggle_execution_h execution)
+{
+	REQUIRE_PARAMETER(execution);
 
-	// Note: this is a hack, and sometimes exists too quickly
-	// TODO: come up with a better solution
-	while (atomic_load(&t->num_pending_subtasks) > 0) { }; 
+	execution_release(execution);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
@@ -8,6 +8,7 @@
 #include "string.h"
 #include "utility/dynamic_array.h"
 #include "utility/hash.h"
+#include "utility/histogram.h"
 #include "utility/return_macro.h"
 
 daggle_error_code_t
@@ -20,11 +21,21 @@ daggle_graph_create(daggle_instance_h instance, daggle_graph_h* out_graph)
 	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(graph);
 
 	// Initialize node list with 0 capacity (success guaranteed)
-	dynamic_array_init(0, sizeof(port_t), &graph->nodes);
+	dynamic_array_init(0, sizeof(node_t*), &graph->nodes);
 
 	graph->instance = instance;
 	graph->owner = NULL;
-	graph->locked = false;
+	atomic_init(&graph->num_executions, 0);
+	graph->revision = 0;
+	graph->num_port_slots = 0;
+	graph->num_node_slots = 0;
+	execution_context_init(graph, &graph->default_context);
+
+	arena_init(&graph->arena);
+	graph->free_nodes = NULL;
+	graph->free_ports = NULL;
+
+	histogram_init(&graph->execution_latency);
 
 	*out_graph = graph;
 
@@ -37,10 +48,25 @@ daggle_graph_free(daggle_graph_h handle)
 	REQUIRE_PARAMETER(handle);
 
 	graph_t* graph = handle;
+
+	if (atomic_load(&graph->num_executions) > 0) {
+		RETURN_STATUS(DAGGLE_ERROR_OBJECT_LOCKED);
+	}
+
+	execution_context_destroy(&graph->default_context);
+
+	// Every node goes, so the links between them are left as they are.
+	for (uint64_t i = 0; i < graph->nodes.length; ++i) {
+		node_t** node = dynamic_array_at(&graph->nodes, i);
+		node_destroy(*node);
+	}
+
 	dynamic_array_destroy(&graph->nodes);
 
-	graph->instance = NULL;
-	graph->owner = NULL;
+	// The nodes and ports, all at once.
+	arena_destroy(&graph->arena);
+
+	free(graph);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
@@ -54,16 +80,19 @@ daggle_graph_add_node(daggle_graph_h handle, const char* type,
 
 	graph_t* graph = handle;
 
-	if (graph->locked) {
+	if (atomic_load(&graph->num_executions) > 0) {
 		RETURN_STATUS(DAGGLE_ERROR_OBJECT_LOCKED);
 	}
 
 	node_t* node;
 	RETURN_IF_ERROR(node_create(graph, type, &node));
 
+	node->index = graph->nodes.length;
 	RETURN_IF_ERROR(
 		dynamic_array_push(&graph->nodes, &node)); // TODO: Free node if error
 
+	++graph->revision;
+
 	*out_node = node;
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
@@ -77,24 +106,35 @@ daggle_graph_remove_node(daggle_graph_h handle, daggle_node_h node)
 
 	graph_t* graph = handle;
 
-	if (graph->locked) {
+	if (atomic_load(&graph->num_executions) > 0) {
 		RETURN_STATUS(DAGGLE_ERROR_OBJECT_LOCKED);
 	}
 
-	for (uint64_t i = 0; i < graph->nodes.length; ++i) {
-		node_t** item = dynamic_array_at(&graph->nodes, i);
+	node_t* node_impl = node;
+	uint64_t index = node_impl->index;
+
+	node_t** item = index < graph->nodes.length
+		? dynamic_array_at(&graph->nodes, index)
+		: NULL;
+
+	if (!item || *item != node_impl) {
+		LOG(LOG_TAG_ERROR, "Node to remove not part of graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
 
-		if (item == node) {
-			dynamic_array_remove(&graph->nodes, i);
+	dynamic_array_remove(&graph->nodes, index);
 
-			node_free(node);
+	node_free(node_impl);
 
-			RETURN_STATUS(DAGGLE_SUCCESS);
-		}
+	// The nodes after the removed one moved down.
+	for (uint64_t i = index; i < graph->nodes.length; ++i) {
+		node_t** moved = dynamic_array_at(&graph->nodes, i);
+		(*moved)->index = i;
 	}
 
-	LOG(LOG_TAG_ERROR, "Node to remove not part of graph");
-	RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	++graph->revision;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
@@ -115,4 +155,26 @@ daggle_graph_get_node_by_index(daggle_graph_h handle, uint64_t index,
 	// If the port does not exist, NULL will be written.
 	*out_node = *node;
 	RETURN_STATUS(DAGGLE_SUCCESS);
-}
\ No newline at end of file
+}
+
+daggle_error_code_t
+daggle_graph_get_execution_latency(daggle_graph_h handle,
+	daggle_duration_summary_t* out_summary)
+{
+	REQUIRE_PARAMETER(handle);
+	REQUIRE_OUTPUT_PARAMETER(out_summary);
+
+	graph_t* graph = handle;
+
+	// A snapshot holds a few kilobytes.
+	histogram_snapshot_t* snapshot = malloc(sizeof *snapshot);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(snapshot);
+
+	histogram_snapshot_init(snapshot);
+	histogram_snapshot_add(snapshot, &graph->execution_latency);
+	histogram_snapshot_summarize(snapshot, out_summary);
+
+	free(snapshot);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
@@ -1,27 +1,94 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "instance.h"
 #include "plugin_manager.h"
 #include "resource_container.h"
+#include "stdio.h"
 #include "stdlib.h"
 #include "utility/return_macro.h"
 
 #include <daggle/daggle.h>
 
+daggle_error_code_t
+daggle_instance_options_init(daggle_instance_options_t* out_options)
+{
+	REQUIRE_OUTPUT_PARAMETER(out_options);
+
+	out_options->num_threads = 0;
+	out_options->cpus = NULL;
+	out_options->num_cpus = 0;
+	out_options->numa_aware = false;
+	out_options->inline_continuation = true;
+	out_options->incremental_execution = false;
+	out_options->release_consumed_values = true;
+	out_options->memo_capacity = 1024;
+	out_options->memo_directory = NULL;
+	out_options->memo_directory_max_bytes = 0;
+	out_options->memo_directory_eviction
+		= DAGGLE_CACHE_EVICTION_LEAST_RECENTLY_USED;
+	out_options->trace_capacity = 0;
+	out_options->task_timing = false;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
 daggle_error_code_t
 daggle_instance_create(daggle_plugin_source_t** plugins, uint64_t num_plugins,
 	daggle_instance_h* out_instance)
 {
 	REQUIRE_OUTPUT_PARAMETER(out_instance);
 
+	RETURN_STATUS(daggle_instance_create_with_options(plugins, num_plugins,
+		NULL, out_instance));
+}
+
+daggle_error_code_t
+daggle_instance_create_with_options(daggle_plugin_source_t** plugins,
+	uint64_t num_plugins, const daggle_instance_options_t* options,
+	daggle_instance_h* out_instance)
+{
+	REQUIRE_OUTPUT_PARAMETER(out_instance);
+
+	daggle_instance_options_t default_options;
+	if (!options) {
+		daggle_instance_options_init(&default_options);
+		options = &default_options;
+	}
+
 	instance_t* instance = malloc(sizeof *instance);
 	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(instance);
 
-	RETURN_IF_ERROR(plugin_manager_init(instance, plugins, num_plugins,
-		&instance->plugin_manager));
-	RETURN_IF_ERROR(executor_init(&instance->executor));
+	instance->incremental_execution = options->incremental_execution;
+	instance->release_consumed_values = options->release_consumed_values;
+
+	daggle_error_code_t error = atom_table_init(&instance->atoms);
+	GOTO_IF_ERROR(error, instance_error);
+
+	error = plugin_manager_init(instance, plugins, num_plugins,
+		&instance->plugin_manager);
+	GOTO_IF_ERROR(error, atoms_error);
+
+	// The executor goes last, its threads are the hardest to take down.
+	error = memo_cache_init(instance, options, &instance->memo_cache);
+	GOTO_IF_ERROR(error, plugin_manager_error);
+
+	error = executor_init(&instance->executor, options);
+	GOTO_IF_ERROR(error, memo_cache_error);
 
 	*out_instance = instance;
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
+
+memo_cache_error:
+	memo_cache_destroy(&instance->memo_cache);
+plugin_manager_error:
+	plugin_manager_destroy(&instance->plugin_manager);
+atoms_error:
+	atom_table_destroy(&instance->atoms);
+instance_error:
+	free(instance);
+
+	RETURN_STATUS(error);
 }
 
 daggle_error_code_t
@@ -33,9 +100,111 @@ daggle_instance_free(daggle_instance_h instance)
 
 	executor_destroy(&instance_impl->executor);
 
+	// The cached and pooled values are freed by the plugins of their types.
+	memo_cache_destroy(&instance_impl->memo_cache);
+	resource_container_drain_pools(&instance_impl->plugin_manager.res,
+		instance);
+
 	plugin_manager_destroy(&instance_impl->plugin_manager);
 
+	atom_table_destroy(&instance_impl->atoms);
+
 	free(instance_impl);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
+
+daggle_error_code_t
+daggle_instance_get_memo_statistics(daggle_instance_h instance,
+	daggle_memo_statistics_t* out_statistics)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_OUTPUT_PARAMETER(out_statistics);
+
+	instance_t* instance_impl = instance;
+	memo_cache_t* cache = &instance_impl->memo_cache;
+
+	out_statistics->hits = atomic_load(&cache->hits);
+	out_statistics->misses = atomic_load(&cache->misses);
+	out_statistics->evictions = atomic_load(&cache->evictions);
+	out_statistics->directory_hits = atomic_load(&cache->disk.hits);
+	out_statistics->directory_writes = atomic_load(&cache->disk.writes);
+	out_statistics->directory_evictions = atomic_load(&cache->disk.evictions);
+
+	pthread_mutex_lock(&cache->lock);
+	out_statistics->num_entries = cache->num_entries;
+	pthread_mutex_unlock(&cache->lock);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_instance_get_executor_statistics(daggle_instance_h instance,
+	daggle_executor_statistics_t* out_statistics)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_OUTPUT_PARAMETER(out_statistics);
+
+	instance_t* instance_impl = instance;
+
+	RETURN_STATUS(
+		executor_get_statistics(&instance_impl->executor, out_statistics));
+}
+
+daggle_error_code_t
+daggle_instance_get_worker_statistics(daggle_instance_h instance,
+	uint64_t worker, daggle_worker_statistics_t* out_statistics)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_OUTPUT_PARAMETER(out_statistics);
+
+	instance_t* instance_impl = instance;
+	executor_t* executor = &instance_impl->executor;
+
+	if (worker >= executor->num_workers) {
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	RETURN_STATUS(
+		executor_get_worker_statistics(executor, worker, out_statistics));
+}
+
+daggle_error_code_t
+daggle_instance_export_trace(daggle_instance_h instance, char** out_json,
+	uint64_t* out_len)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_OUTPUT_PARAMETER(out_json);
+
+	instance_t* instance_impl = instance;
+
+	char* json = NULL;
+	size_t len = 0;
+	FILE* stream = open_memstream(&json, &len);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(stream);
+
+	executor_write_trace(&instance_impl->executor, stream);
+
+	if (fclose(stream) != 0) {
+		free(json);
+		RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+	}
+
+	*out_json = json;
+	if (out_len) {
+		*out_len = len;
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_instance_clear_trace(daggle_instance_h instance)
+{
+	REQUIRE_PARAMETER(instance);
+
+	instance_t* instance_impl = instance;
+	executor_clear_trace(&instance_impl->executor);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
@@ -10,7 +10,8 @@
 daggle_error_code_t
 prv_node_declare_port(daggle_port_variant_t variant, daggle_node_h node,
 	const char* port_name, daggle_input_behavior_t input_behavior,
-	daggle_default_value_generator_fn default_value_gen)
+	daggle_default_value_generator_fn default_value_gen,
+	daggle_port_id_t* out_id)
 {
 	ASSERT_PARAMETER(node);
 	ASSERT_PARAMETER(port_name);
@@ -18,13 +19,16 @@ prv_node_declare_port(daggle_port_variant_t variant, daggle_node_h node,
 	// Cast from opaque back to the real type.
 	node_t* node_impl = node;
 
-	port_t* preexisting_port;
-	daggle_node_get_port_by_name(node_impl, port_name,
-		(daggle_port_h*)&preexisting_port);
+	port_t* preexisting_port = node_get_port_by_name(node_impl, port_name);
 
-	// If the port already exists -> flag as declared.
+	// If the port already exists -> flag as declared. It keeps the id.
 	if (preexisting_port) {
 		preexisting_port->declared = true;
+
+		if (out_id) {
+			*out_id = preexisting_port->id;
+		}
+
 		RETURN_STATUS(DAGGLE_SUCCESS);
 	}
 
@@ -44,53 +48,69 @@ prv_node_declare_port(daggle_port_variant_t variant, daggle_node_h node,
 		data_container_init(instance, &default_value_cnt);
 	}
 
-	port_t new_port;
-	port_init(node_impl, port_name, variant, &new_port);
-	new_port.value = default_value_cnt;
+	port_t* new_port = graph_alloc_port(graph);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(new_port);
+
+	port_init(node_impl, port_name, variant, new_port);
+	new_port->value = default_value_cnt;
 
 	if (variant == DAGGLE_PORT_INPUT) {
-		new_port.variant.input.behavior = input_behavior;
+		new_port->variant.input.behavior = input_behavior;
 	}
 
 	// Set the created port as declared.
-	new_port.declared = true;
+	new_port->declared = true;
+
+	daggle_error_code_t error = node_add_port(node_impl, new_port);
+	if (error != DAGGLE_SUCCESS) {
+		port_destroy(new_port);
+		graph_release_port(graph, new_port);
+		RETURN_STATUS(error);
+	}
 
-	RETURN_STATUS(dynamic_array_push(&node_impl->ports, &new_port));
+	if (out_id) {
+		*out_id = new_port->id;
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
 daggle_node_declare_input(daggle_node_h node, const char* port_name,
 	daggle_input_behavior_t input_behavior,
-	daggle_default_value_generator_fn default_value_gen)
+	daggle_default_value_generator_fn default_value_gen,
+	daggle_port_id_t* out_id)
 {
 	REQUIRE_PARAMETER(node);
 	REQUIRE_PARAMETER(port_name);
 	REQUIRE_PARAMETER(default_value_gen);
 
 	RETURN_STATUS(prv_node_declare_port(DAGGLE_PORT_INPUT, node, port_name,
-		input_behavior, default_value_gen));
+		input_behavior, default_value_gen, out_id));
 }
 
 daggle_error_code_t
 daggle_node_declare_parameter(daggle_node_h node, const char* port_name,
-	daggle_default_value_generator_fn default_value_gen)
+	daggle_default_value_generator_fn default_value_gen,
+	daggle_port_id_t* out_id)
 {
 	REQUIRE_PARAMETER(node);
 	REQUIRE_PARAMETER(port_name);
 	REQUIRE_PARAMETER(default_value_gen);
 
 	RETURN_STATUS(prv_node_declare_port(DAGGLE_PORT_PARAMETER, node, port_name,
-		false, default_value_gen));
+		false, default_value_gen, out_id));
 }
 
 daggle_error_code_t
-daggle_node_declare_output(daggle_node_h node, const char* port_name)
+daggle_node_declare_output(daggle_node_h node, const char* port_name,
+	daggle_port_id_t* out_id)
 {
 	REQUIRE_PARAMETER(node);
 	REQUIRE_PARAMETER(port_name);
 
 	RETURN_STATUS(prv_node_declare_port(DAGGLE_PORT_OUTPUT, node, port_name,
-		false, NULL));
+		false, NULL, out_id));
 }
 
 daggle_error_code_t
@@ -123,6 +143,28 @@ daggle_node_declare_context(daggle_node_h node, void* context,
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
+daggle_error_code_t
+daggle_node_declare_memoized(daggle_node_h node)
+{
+	REQUIRE_PARAMETER(node);
+
+	node_t* internal_node = node;
+	internal_node->is_memoized = true;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_node_declare_volatile(daggle_node_h node)
+{
+	REQUIRE_PARAMETER(node);
+
+	node_t* internal_node = node;
+	internal_node->is_volatile = true;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
 daggle_error_code_t
 daggle_node_get_type(daggle_node_h node, const char** out_type)
 {
@@ -193,4 +235,15 @@ daggle_node_get_port_by_index(daggle_node_h node, uint64_t index,
 
 	*out_port = port;
 	RETURN_STATUS(DAGGLE_SUCCESS);
-}
\ No newline at end of file
+}
+
+daggle_error_code_t
+daggle_node_get_port_by_id(daggle_node_h node, daggle_port_id_t id,
+	daggle_port_h* out_port)
+{
+	REQUIRE_PARAMETER(node);
+	REQUIRE_OUTPUT_PARAMETER(out_port);
+
+	*out_port = node_get_port_by_id(node, id);
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
@@ -3,9 +3,11 @@
 #include "node.h"
 #include "ports.h"
 #include "resource_container.h"
+#include "shared_value.h"
 #include "utility/log_macro.h"
 #include "utility/return_macro.h"
 #include "stdatomic.h"
+#include "string.h"
 
 #include <daggle/daggle.h>
 #include <stdint.h>
@@ -62,6 +64,11 @@ daggle_port_connect(daggle_port_h port_a, daggle_port_h port_b)
 
 	// Set connections
 	target->variant.input.link = source;
+	target->variant.input.link_index = source->variant.output.links.length;
+
+	graph_t* graph = target_parent->graph;
+	++graph->revision;
+	++target_parent->version;
 
 	// Push a pointer to the target node to the link array.
 	// Push copies stride bytes from the address data points to.
@@ -71,9 +78,33 @@ daggle_port_connect(daggle_port_h port_a, daggle_port_h port_b)
 	RETURN_STATUS(dynamic_array_push(&source->variant.output.links, &target));
 }
 
-// disconnection_index is a pointer to enable optional usage.
+// Remove the link of an input. The last link of the output takes the place of
+// the removed one, so the input doesn't have to be searched for.
+void
+prv_input_unlink(port_t* port)
+{
+	port_t* link = port->variant.input.link;
+	dynamic_array_t* links = &link->variant.output.links;
+	uint64_t index = port->variant.input.link_index;
+
+	port_t** last = dynamic_array_at(links, links->length - 1);
+	port_t** element = dynamic_array_at(links, index);
+
+	*element = *last;
+	(*element)->variant.input.link_index = index;
+	--links->length;
+
+	port->variant.input.link = NULL;
+	port->variant.input.link_index = 0;
+
+	node_t* port_owner = port->owner;
+	graph_t* graph = port_owner->graph;
+	++graph->revision;
+	++port_owner->version;
+}
+
 daggle_error_code_t
-prv_port_disconnect(port_t* port, const uint64_t* disconnection_index)
+prv_port_disconnect(port_t* port)
 {
 	ASSERT_PARAMETER(port);
 
@@ -81,80 +112,31 @@ prv_port_disconnect(port_t* port, const uint64_t* disconnection_index)
 	LOG_FMT_COND_DEBUG("Disconnect %s %s", port_owner->info->name_hash.name,
 		port->name_hash.name);
 
-	if (port->port_variant == DAGGLE_PORT_PARAMETER) {
+	switch (port->port_variant) {
+	case DAGGLE_PORT_PARAMETER:
 		// Parameters can't have edges, return an error.
 		RETURN_STATUS(DAGGLE_ERROR_INCORRECT_PORT_VARIANT);
-	} else if (port->port_variant == DAGGLE_PORT_OUTPUT) {
+	case DAGGLE_PORT_OUTPUT: {
+		// Disconnect every connected input. Unlinking from the back moves
+		// nothing around.
 		dynamic_array_t* links = &port->variant.output.links;
-		if (disconnection_index) {
-			port_t** element = dynamic_array_at(links, *disconnection_index);
-			port_t* item = *element;
-
-			// The outgoing edge index was specified. Disconnect that
-			// edge using the input port of that.
-			// At provides a pointer to the data. The link array stores pointers
-			// towards other ports, therefore the return type is port**.
-			RETURN_STATUS(prv_port_disconnect(item, disconnection_index));
-		} else {
-			// An outgoing edge was not sepcified. Disconnect every conencted
-			// edge. Due to the way dynamic array was implemented, it makes more
-			// sense to disconnect the ports in a reverse order.
-			for (int i = links->length - 1; i >= 0; --i) {
-				port_t** element = dynamic_array_at(links, i);
-				port_t* item = *element;
-
-				// We're using an int here to prevent the uint64_t from
-				// overflowing. However, the function uses a pointer to a
-				// uint64_t instead of an int, which is why i is cast into the
-				// index variable.
-				const uint64_t index = i;
-				RETURN_IF_ERROR(prv_port_disconnect(item, &index));
-			}
-
-			RETURN_STATUS(DAGGLE_SUCCESS);
+		while (links->length > 0) {
+			port_t** element = dynamic_array_at(links, links->length - 1);
+			prv_input_unlink(*element);
 		}
-	} else if (port->port_variant == DAGGLE_PORT_INPUT) {
-		// Get the output (source) port of the edge.
-		port_t* link = port->variant.input.link;
 
-		// Return if the port does not have an edge to disconnect.
-		if (!link) {
-			RETURN_STATUS(DAGGLE_SUCCESS);
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+	case DAGGLE_PORT_INPUT:
+		// Nothing to do if the port does not have an edge.
+		if (port->variant.input.link) {
+			prv_input_unlink(port);
 		}
 
-		// Get the list of connected input (target) ports of the source port.
-		dynamic_array_t* links = &link->variant.output.links;
-
-		if (disconnection_index) {
-			// Remove link from the target.
-			port->variant.input.link = NULL;
-
-			// Remove link from the source.
-			dynamic_array_remove(links, *disconnection_index);
-
-			RETURN_STATUS(DAGGLE_SUCCESS);
-		} else {
-			// Get the index of the input port in the edge list of the
-			// connected output port. If it is found (it definitely should),
-			// call this function with the index of the port.
-			for (uint64_t i = 0; i < links->length; ++i) {
-				port_t** element = dynamic_array_at(links, i);
-				port_t* item = *element;
-
-				if (item != link) {
-					continue;
-				}
-
-				RETURN_STATUS(prv_port_disconnect(item, &i));
-			}
-
-			// Port was not found, should not happen.
-			RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
-		}
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	default:
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
 	}
-
-	// It shouldn't be possible to reach this.
-	RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
 }
 
 daggle_error_code_t
@@ -162,7 +144,7 @@ daggle_port_disconnect(daggle_port_h port)
 {
 	REQUIRE_PARAMETER(port);
 
-	RETURN_STATUS(prv_port_disconnect(port, NULL));
+	RETURN_STATUS(prv_port_disconnect(port));
 }
 
 daggle_error_code_t
@@ -227,6 +209,19 @@ daggle_port_get_node(const daggle_port_h port, daggle_node_h* out_node)
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
+daggle_error_code_t
+daggle_port_get_id(const daggle_port_h port, daggle_port_id_t* out_id)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_id);
+
+	const port_t* port_impl = port;
+
+	*out_id = port_impl->id;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
 daggle_error_code_t
 daggle_port_get_variant(const daggle_port_h port,
 	daggle_port_variant_t* out_variant)
@@ -242,6 +237,23 @@ daggle_port_get_variant(const daggle_port_h port,
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
+daggle_error_code_t
+prv_container_get_data_type(const data_container_t* container,
+	const char** out_data_type)
+{
+	if (!container || !data_container_has_value(container)) {
+		*out_data_type = "";
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	ASSERT_NOT_NULL(container->info->name_hash.name,
+		"The type of the value of the port is null");
+
+	*out_data_type = container->info->name_hash.name;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
 daggle_error_code_t
 daggle_port_get_value_data_type(const daggle_port_h port,
 	const char** out_data_type)
@@ -249,63 +261,108 @@ daggle_port_get_value_data_type(const daggle_port_h port,
 	REQUIRE_PARAMETER(port);
 	REQUIRE_OUTPUT_PARAMETER(out_data_type);
 
-	const port_t* port_impl = port;
-
-	const data_container_t* data_location = &port_impl->value;
+	port_t* port_impl = port;
+	execution_context_t* context = execution_context_resolve(port_impl);
 
-	// If the port is input and the input has an edge with data,
-	// return the type of the edge-provided data.
-	if (port_impl->port_variant == DAGGLE_PORT_INPUT
-		&& port_impl->variant.input.link != NULL) {
-		port_t* link = port_impl->variant.input.link;
-		data_location = &link->value;
-	}
+	RETURN_STATUS(prv_container_get_data_type(
+		port_get_container(port_impl, context), out_data_type));
+}
 
-	if (!data_container_has_value(data_location)) {
-		*out_data_type = "";
-		RETURN_STATUS(DAGGLE_SUCCESS);
-	}
+daggle_error_code_t
+daggle_port_get_value_type(const daggle_port_h port, daggle_type_h* out_type)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_type);
 
-	ASSERT_NOT_NULL(data_location->info->name_hash.name,
-		"The type of the value of the port is null");
+	port_t* port_impl = port;
+	execution_context_t* context = execution_context_resolve(port_impl);
+	data_container_t* container = port_get_container(port_impl, context);
 
-	*out_data_type = data_location->info->name_hash.name;
+	*out_type = container && data_container_has_value(container)
+		? container->info
+		: NULL;
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 void
-prv_port_get_value_as_reference(port_t* port, void** out_data)
+prv_container_get_value_as_reference(data_container_t* container,
+	void** out_data)
 {
-	ASSERT_PARAMETER(port);
 	ASSERT_OUTPUT_PARAMETER(out_data);
 
 	// If the port does not have data, return NULL.
-	if (!data_container_has_value(&port->value)) {
+	if (!container || !data_container_has_value(container)) {
 		*out_data = NULL;
 		return;
 	}
 
 	// Parameter ports return an immutable pointer to the stored data.
-	*out_data = port->value.data;
+	*out_data = container->data;
 }
 
 void
-prv_port_get_value_as_copy(port_t* port, void** out_data)
+prv_container_get_value_as_copy(data_container_t* container, void** out_data)
 {
-	ASSERT_PARAMETER(port);
 	ASSERT_OUTPUT_PARAMETER(out_data);
 
 	// If the port does not have data, return NULL.
-	if (!data_container_has_value(&port->value)) {
+	if (!container || !data_container_has_value(container)) {
 		*out_data = NULL;
 		return;
 	}
 
-	port_t* port_impl = port;
+	daggle_data_clone_typed(container->instance, container->info,
+		container->data, out_data);
+}
 
-	daggle_data_clone(port->value.instance, port->value.info->name_hash.name,
-		port->value.data, out_data);
+// Spend the access of an input in an execution of the context. Writes
+// whether the value may be taken from its source, which is the case for the
+// last access of an acquired output, unless outputs are kept for the next
+// execution. The source is read before prv_input_finish_access lets the last
+// access take it.
+bool
+prv_input_spend_access(port_t* port, execution_context_t* context,
+	bool* out_is_taken)
+{
+	context_port_t* state = execution_context_get_port(context, port);
+	if (!state || state->has_spent_access) {
+		LOG(LOG_TAG_ERROR, "Attempting to get value without access");
+		return false;
+	}
+
+	state->has_spent_access = true;
+	*out_is_taken = false;
+
+	port_t* link = port->variant.input.link;
+	if (port->variant.input.behavior != DAGGLE_INPUT_BEHAVIOR_ACQUIRE
+		|| !link) {
+		return true;
+	}
+
+	context_port_t* link_state = execution_context_get_port(context, link);
+
+	// Taking an output kept for the next execution would make its node run
+	// again.
+	bool is_retained = execution_context_is_output_retained(link);
+
+	// Acquire is available only if port is linked, and it is the only link from the output
+	*out_is_taken = !is_retained
+		&& atomic_load(&link_state->num_pending_accesses) == 1;
+
+	return true;
+}
+
+void
+prv_input_finish_access(port_t* port, execution_context_t* context)
+{
+	port_t* link = port->variant.input.link;
+	if (port->variant.input.behavior != DAGGLE_INPUT_BEHAVIOR_ACQUIRE
+		|| !link) {
+		return;
+	}
+
+	execution_context_finish_access(context, link);
 }
 
 void
@@ -314,52 +371,123 @@ prv_input_get_value(port_t* port, void** out_data)
 	ASSERT_PARAMETER(port);
 	ASSERT_OUTPUT_PARAMETER(out_data);
 
-	// Get pointer to the port, which the provided input is connected to.
-	// This is NULL when the input does not have an edge.
-	port_t* link = port->variant.input.link;
+	execution_context_t* context = execution_context_resolve(port);
+	data_container_t* source = port_get_container(port, context);
 
-	node_t* port_owner = port->owner;
-	graph_t* graph = port_owner->graph;
+	// Outside of executions the value is only looked at.
+	if (!atomic_load(&context->executing)) {
+		prv_container_get_value_as_reference(source, out_data);
+		return;
+	}
 
-	// Determine which port to use as the source.
-	port_t* target_port = link ? link : port;
+	bool is_taken;
+	if (!prv_input_spend_access(port, context, &is_taken)) {
+		*out_data = NULL;
+		return;
+	}
 
-	if(!graph->locked) {
-		prv_port_get_value_as_reference(target_port, out_data);
+	if (port->variant.input.behavior == DAGGLE_INPUT_BEHAVIOR_REFERENCE) {
+		prv_container_get_value_as_reference(source, out_data);
+		return;
 	}
 
-	if(port->variant.input.has_spent_access) {
-		LOG(LOG_TAG_ERROR, "Attempting to get value without access");
-		*out_data = NULL;
+	if (!is_taken) {
+		prv_container_get_value_as_copy(source, out_data);
+		prv_input_finish_access(port, context);
+		return;
 	}
 
-	port->variant.input.has_spent_access = true;
+	// Scratch and inline memory is not the caller's to own, it gets a copy
+	// and the original is left to the arena or the container. Shared values
+	// are copied only if other consumers still hold them.
+	if (source->shared) {
+		*out_data = shared_value_take(source->shared);
+	} else if (source->is_scratch || source->is_inline) {
+		prv_container_get_value_as_copy(source, out_data);
+	} else {
+		*out_data = source->data;
+	}
 
-	switch (port->variant.input.behavior) {
-	case DAGGLE_INPUT_BEHAVIOR_REFERENCE:
-		prv_port_get_value_as_reference(target_port, out_data);
-		break;
-	case DAGGLE_INPUT_BEHAVIOR_ACQUIRE:
-		// TODO: In some cases, it might make sense to disable acquiring if
-		// the output belongs to a node, which is computationally very intensive
-		// it might make sense to cache the output. For example, allow the node
-		// to flag outputs to be cached. Changes to parameters (or if node is 
-		// otherwise volatile) would set the node dirty
-
-		// Acquire is available only if port is linked, and it is the only link from the output
-		if (link && atomic_load(&link->variant.output.num_pending_accesses) == 1) {
-			*out_data = link->value.data;
-			link->value.data = NULL;
-			link->value.info = NULL;
-		} else {
-			prv_port_get_value_as_copy(target_port, out_data);	
-		}
+	data_container_forget(source);
+
+	prv_input_finish_access(port, context);
+}
+
+// Reference to the value of a container, NULL if there is none. Unless the
+// value is taken, the container keeps holding it.
+shared_value_t*
+prv_container_get_shared_value(data_container_t* container, bool is_taken)
+{
+	if (!container || !data_container_has_value(container)) {
+		return NULL;
+	}
+
+	shared_value_t* value = container->shared;
+
+	if (value && is_taken) {
+		data_container_forget(container);
+		return value;
+	}
+
+	if (value) {
+		shared_value_retain(value);
+		return value;
+	}
+
+	void* data = NULL;
+	if (is_taken && !container->is_scratch && !container->is_inline) {
+		data = container->data;
+	} else {
+		prv_container_get_value_as_copy(container, &data);
+	}
 
-		if(link) {
-			atomic_fetch_sub(&link->variant.output.num_pending_accesses, 1);
+	value = shared_value_create(container->instance, container->info, data);
+	if (!value) {
+		// Taken data stays with the container.
+		if (data != container->data) {
+			daggle_data_free_typed(container->instance, container->info,
+				data);
 		}
-		break;
+
+		return NULL;
+	}
+
+	// Moved or copied, either way the container no longer holds the value.
+	if (is_taken) {
+		data_container_forget(container);
+	}
+
+	return value;
+}
+
+daggle_error_code_t
+daggle_port_get_shared_value(const daggle_port_h port,
+	daggle_value_h* out_value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	port_t* port_impl = port;
+	execution_context_t* context = execution_context_resolve(port_impl);
+	data_container_t* source = port_get_container(port_impl, context);
+
+	if (port_impl->port_variant != DAGGLE_PORT_INPUT
+		|| !atomic_load(&context->executing)) {
+		*out_value = prv_container_get_shared_value(source, false);
+		RETURN_STATUS(DAGGLE_SUCCESS);
 	}
+
+	bool is_taken;
+	if (!prv_input_spend_access(port_impl, context, &is_taken)) {
+		*out_value = NULL;
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	*out_value = prv_container_get_shared_value(source, is_taken);
+
+	prv_input_finish_access(port_impl, context);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 // TODO: Make separate function for input, one for prv_input_get_value, one for
@@ -379,7 +507,10 @@ daggle_port_get_value(const daggle_port_h port, void** out_data)
 		break;
 	case DAGGLE_PORT_PARAMETER:
 	case DAGGLE_PORT_OUTPUT:
-		prv_port_get_value_as_reference(port_impl, out_data);
+		prv_container_get_value_as_reference(
+			port_get_container(port_impl,
+				execution_context_resolve(port_impl)),
+			out_data);
 		break;
 	default:
 		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
@@ -395,6 +526,34 @@ daggle_port_set_value(const daggle_port_h port, const char* data_type,
 	REQUIRE_PARAMETER(port);
 	REQUIRE_PARAMETER(data_type);
 
+	port_t* port_impl = port;
+	node_t* port_owner = port_impl->owner;
+	graph_t* graph = port_owner->graph;
+
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&graph->instance->plugin_manager.res, data_type, &info));
+
+	RETURN_STATUS(daggle_port_set_value_typed(port, info, data));
+}
+
+// How the data given to prv_port_set_value is held.
+typedef enum prv_value_storage_e {
+	// Owned by the port from now on.
+	PRV_VALUE_STORAGE_OWNED,
+	// Allocated from the scratch arena of the execution.
+	PRV_VALUE_STORAGE_SCRATCH,
+	// Borrowed from the caller, copied into the port, inline if the type
+	// allows it.
+	PRV_VALUE_STORAGE_COPY,
+	// Reference to a shared value taken over from the caller.
+	PRV_VALUE_STORAGE_SHARED,
+} prv_value_storage_t;
+
+daggle_error_code_t
+prv_port_set_value(port_t* port_impl, type_info_t* info, void* data,
+	prv_value_storage_t storage)
+{
 	// TODO: Critical! Return error if node is currently being declared.
 	// If a port is being set, it will run compute declarations twice
 	// (potentially loops infinitely), breaking it.
@@ -403,13 +562,15 @@ daggle_port_set_value(const daggle_port_h port, const char* data_type,
 	// Which means implementing some sort of port data type constraint system,
 	// and ideally data conversions.
 
-	port_t* port_impl = port;
-
 	node_t* port_owner = port_impl->owner;
 	graph_t* graph = port_owner->graph;
-	instance_t* instance = graph->instance;
 
-	bool is_locked = graph->locked;
+	execution_context_t* context = execution_context_resolve(port_impl);
+
+	// Parameters are shared by every context of the graph, outputs are only
+	// written by the nodes while executing.
+	bool is_locked = atomic_load(&graph->num_executions) > 0;
+	bool is_executing = atomic_load(&context->executing);
 
 	bool is_port_input = port_impl->port_variant == DAGGLE_PORT_INPUT;
 	bool is_port_output = port_impl->port_variant == DAGGLE_PORT_OUTPUT;
@@ -429,7 +590,7 @@ daggle_port_set_value(const daggle_port_h port, const char* data_type,
 	}
 
 	// If setting output outside of a node.
-	if (!is_locked && is_port_output) {
+	if (!is_executing && is_port_output) {
 		ASSERT_TRUE(false,
 			"Changing output port while not locked; allow "
 			"if intentional "
@@ -438,15 +599,53 @@ daggle_port_set_value(const daggle_port_h port, const char* data_type,
 	}
 
 	// If setting linked value outside of a node.
-	if (!is_locked && is_port_linked_input) {
+	if (!is_executing && is_port_linked_input) {
 		LOG(LOG_TAG_WARN, "Setting linked input port outside of node!");
 	}
 
-	type_info_t* info;
-	RETURN_IF_ERROR(resource_container_get_type(&instance->plugin_manager.res,
-		data_type, &info));
+	// Values set while executing belong to the context, others are the
+	// defaults stored in the graph.
+	data_container_t* target = &port_impl->value;
+	if (is_port_output || (is_executing && is_port_input)) {
+		context_port_t* state = execution_context_get_port(context, port_impl);
+		REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(state);
+
+		target = &state->value;
+	}
+
+	// Scratch memory is gone after the execution, the graph would outlive it.
+	if (storage == PRV_VALUE_STORAGE_SCRATCH && target == &port_impl->value) {
+		LOG(LOG_TAG_ERROR, "Setting scratch value outside of an execution");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
 
-	data_container_replace(&port_impl->value, info, data);
+	switch (storage) {
+	case PRV_VALUE_STORAGE_OWNED:
+		data_container_replace(target, info, data);
+		break;
+	case PRV_VALUE_STORAGE_SCRATCH:
+		data_container_replace_scratch(target, info, data);
+		break;
+	case PRV_VALUE_STORAGE_COPY:
+		data_container_replace_copy(target, info, data);
+		break;
+	case PRV_VALUE_STORAGE_SHARED:
+		data_container_replace_shared(target, data);
+		break;
+	}
+
+	if (is_port_input) {
+		// The node has to run again, in this context or in every one.
+		if (target == &port_impl->value) {
+			++port_owner->version;
+		} else {
+			context_node_t* node_state
+				= execution_context_get_node(context, port_owner);
+			REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(node_state);
+
+			node_state->is_dirty = true;
+		}
+	}
 
 	if (is_port_param) {
 		// A parameter was changed, should invoke node redeclaration.
@@ -455,3 +654,321 @@ daggle_port_set_value(const daggle_port_h port, const char* data_type,
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
+
+daggle_error_code_t
+daggle_port_set_value_typed(const daggle_port_h port, daggle_type_h type,
+	void* data)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(
+		prv_port_set_value(port, type, data, PRV_VALUE_STORAGE_OWNED));
+}
+
+daggle_error_code_t
+daggle_port_set_scratch_value(const daggle_port_h port, daggle_type_h type,
+	void* data)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(
+		prv_port_set_value(port, type, data, PRV_VALUE_STORAGE_SCRATCH));
+}
+
+daggle_error_code_t
+daggle_port_set_value_copy(const daggle_port_h port, daggle_type_h type,
+	const void* data)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+	REQUIRE_PARAMETER(data);
+
+	RETURN_STATUS(
+		prv_port_set_value(port, type, (void*)data, PRV_VALUE_STORAGE_COPY));
+}
+
+daggle_error_code_t
+daggle_port_set_shared_value(const daggle_port_h port, daggle_value_h value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(value);
+
+	shared_value_t* value_impl = value;
+
+	RETURN_STATUS(prv_port_set_value(port, value_impl->info, value,
+		PRV_VALUE_STORAGE_SHARED));
+}
+
+// Copy a scalar out of a value of a trivially copyable type.
+daggle_error_code_t
+prv_container_get_scalar(data_container_t* container, uint64_t size,
+	void* out_value)
+{
+	if (!container || !data_container_has_value(container)) {
+		LOG(LOG_TAG_ERROR, "Port has no value");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	type_info_t* info = container->info;
+	if (!info->is_trivially_copyable || info->size != size) {
+		LOG_FMT(LOG_TAG_ERROR, "%s is not a scalar of %llu bytes",
+			info->name_hash.name, (unsigned long long)size);
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	memcpy(out_value, container->data, size);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// Copy a scalar out of the value of a port, taking it from its source if it is
+// the last access of an acquired output.
+daggle_error_code_t
+prv_port_get_scalar(port_t* port, uint64_t size, void* out_value)
+{
+	execution_context_t* context = execution_context_resolve(port);
+	data_container_t* source = port_get_container(port, context);
+
+	if (port->port_variant != DAGGLE_PORT_INPUT
+		|| !atomic_load(&context->executing)) {
+		RETURN_STATUS(prv_container_get_scalar(source, size, out_value));
+	}
+
+	bool is_taken;
+	if (!prv_input_spend_access(port, context, &is_taken)) {
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	daggle_error_code_t error
+		= prv_container_get_scalar(source, size, out_value);
+
+	if (is_taken && error == DAGGLE_SUCCESS) {
+		data_container_destroy(source);
+	}
+
+	prv_input_finish_access(port, context);
+
+	RETURN_STATUS(error);
+}
+
+daggle_error_code_t
+prv_port_set_scalar(port_t* port, type_info_t* info, uint64_t size,
+	const void* value)
+{
+	if (!info->is_inline || info->size != size) {
+		LOG_FMT(LOG_TAG_ERROR, "%s is not a scalar of %llu bytes",
+			info->name_hash.name, (unsigned long long)size);
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	RETURN_STATUS(prv_port_set_value(port, info, (void*)value,
+		PRV_VALUE_STORAGE_COPY));
+}
+
+daggle_error_code_t
+daggle_port_get_i32(const daggle_port_h port, int32_t* out_value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	RETURN_STATUS(prv_port_get_scalar(port, sizeof *out_value, out_value));
+}
+
+daggle_error_code_t
+daggle_port_get_i64(const daggle_port_h port, int64_t* out_value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	RETURN_STATUS(prv_port_get_scalar(port, sizeof *out_value, out_value));
+}
+
+daggle_error_code_t
+daggle_port_get_f32(const daggle_port_h port, float* out_value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	RETURN_STATUS(prv_port_get_scalar(port, sizeof *out_value, out_value));
+}
+
+daggle_error_code_t
+daggle_port_get_f64(const daggle_port_h port, double* out_value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	RETURN_STATUS(prv_port_get_scalar(port, sizeof *out_value, out_value));
+}
+
+daggle_error_code_t
+daggle_port_get_bool(const daggle_port_h port, bool* out_value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	RETURN_STATUS(prv_port_get_scalar(port, sizeof *out_value, out_value));
+}
+
+daggle_error_code_t
+daggle_port_set_i32(const daggle_port_h port, daggle_type_h type,
+	int32_t value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(prv_port_set_scalar(port, type, sizeof value, &value));
+}
+
+daggle_error_code_t
+daggle_port_set_i64(const daggle_port_h port, daggle_type_h type,
+	int64_t value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(prv_port_set_scalar(port, type, sizeof value, &value));
+}
+
+daggle_error_code_t
+daggle_port_set_f32(const daggle_port_h port, daggle_type_h type,
+	float value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(prv_port_set_scalar(port, type, sizeof value, &value));
+}
+
+daggle_error_code_t
+daggle_port_set_f64(const daggle_port_h port, daggle_type_h type,
+	double value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(prv_port_set_scalar(port, type, sizeof value, &value));
+}
+
+daggle_error_code_t
+daggle_port_set_bool(const daggle_port_h port, daggle_type_h type,
+	bool value)
+{
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(type);
+
+	RETURN_STATUS(prv_port_set_scalar(port, type, sizeof value, &value));
+}
+
+daggle_error_code_t
+daggle_execution_context_get_value(daggle_execution_context_h context,
+	const daggle_port_h port, void** out_data)
+{
+	REQUIRE_PARAMETER(context);
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
+
+	port_t* port_impl = port;
+	execution_context_t* context_impl = context;
+
+	node_t* port_owner = port_impl->owner;
+	if (context_impl->graph != port_owner->graph) {
+		LOG(LOG_TAG_ERROR, "The port belongs to another graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	prv_container_get_value_as_reference(
+		port_get_container(port_impl, context_impl), out_data);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_execution_context_get_shared_value(daggle_execution_context_h context,
+	const daggle_port_h port, daggle_value_h* out_value)
+{
+	REQUIRE_PARAMETER(context);
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_value);
+
+	port_t* port_impl = port;
+	execution_context_t* context_impl = context;
+
+	node_t* port_owner = port_impl->owner;
+	if (context_impl->graph != port_owner->graph) {
+		LOG(LOG_TAG_ERROR, "The port belongs to another graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	*out_value = prv_container_get_shared_value(
+		port_get_container(port_impl, context_impl), false);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_execution_context_get_value_data_type(
+	daggle_execution_context_h context, const daggle_port_h port,
+	const char** out_data_type)
+{
+	REQUIRE_PARAMETER(context);
+	REQUIRE_PARAMETER(port);
+	REQUIRE_OUTPUT_PARAMETER(out_data_type);
+
+	port_t* port_impl = port;
+	execution_context_t* context_impl = context;
+
+	node_t* port_owner = port_impl->owner;
+	if (context_impl->graph != port_owner->graph) {
+		LOG(LOG_TAG_ERROR, "The port belongs to another graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	RETURN_STATUS(prv_container_get_data_type(
+		port_get_container(port_impl, context_impl), out_data_type));
+}
+
+daggle_error_code_t
+daggle_execution_context_set_value(daggle_execution_context_h context,
+	const daggle_port_h port, const char* data_type, void* data)
+{
+	REQUIRE_PARAMETER(context);
+	REQUIRE_PARAMETER(port);
+	REQUIRE_PARAMETER(data_type);
+
+	port_t* port_impl = port;
+	execution_context_t* context_impl = context;
+
+	node_t* port_owner = port_impl->owner;
+	graph_t* graph = port_owner->graph;
+	if (context_impl->graph != graph) {
+		LOG(LOG_TAG_ERROR, "The port belongs to another graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	// Outputs are written by the nodes, and parameters are shared by every
+	// context.
+	if (port_impl->port_variant != DAGGLE_PORT_INPUT) {
+		RETURN_STATUS(DAGGLE_ERROR_INCORRECT_PORT_VARIANT);
+	}
+
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&graph->instance->plugin_manager.res, data_type, &info));
+
+	context_port_t* state = execution_context_get_port(context_impl, port_impl);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(state);
+
+	context_node_t* node_state
+		= execution_context_get_node(context_impl, port_owner);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(node_state);
+
+	data_container_replace(&state->value, info, data);
+
+	// Run the node again in this context.
+	node_state->is_dirty = true;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
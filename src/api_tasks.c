@@ -3,6 +3,7 @@
 #include "stdatomic.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "utility/log_macro.h"
 #include "utility/return_macro.h"
 
 void
@@ -17,21 +18,14 @@ prv_sink_dispose(void* context)
 	task_free(task);
 }
 
-typedef struct prv_node_task_wrapper_ctx {
-	task_t* task;
-	daggle_node_task_fn function;
-	daggle_node_task_dispose_fn dispose;
-	void* context;
-} prv_node_task_wrapper_ctx_t;
-
 void
 prv_node_task_wrapper_function(void* context)
 {
 	ASSERT_NOT_NULL(context, "context is null");
 
-	prv_node_task_wrapper_ctx_t* context_impl = context;
+	task_t* task = context;
 
-	context_impl->function(context_impl->task, context_impl->context);
+	task->node_function(task, task->node_context);
 }
 
 void
@@ -39,13 +33,57 @@ prv_node_task_wrapper_dispose(void* context)
 {
 	ASSERT_NOT_NULL(context, "context is null");
 
-	prv_node_task_wrapper_ctx_t* context_impl = context;
+	task_t* task = context;
+
+	if (task->node_dispose) {
+		task->node_dispose(task->node_context);
+	}
+}
+
+void
+task_set_node_task(task_t* task, daggle_node_task_fn work,
+	daggle_node_task_dispose_fn dispose, void* context)
+{
+	ASSERT_PARAMETER(task);
+
+	// The node task is stored in the task itself, the work calls it.
+	task->node_function = work;
+	task->node_dispose = dispose;
+	task->node_context = context;
+
+	task->work.function = prv_node_task_wrapper_function;
+	task->work.dispose = prv_node_task_wrapper_dispose;
+	task->work.context = task;
+}
+
+task_t*
+task_create_sink(task_t* task)
+{
+	ASSERT_PARAMETER(task);
 
-	if (context_impl->dispose) {
-		context_impl->dispose(context_impl->context);
+	task_t* tail = task_alloc();
+	if (!tail) {
+		return NULL;
 	}
 
-	free(context_impl);
+	tail->head = task;
+	tail->priority = task->priority;
+	tail->id = "sink";
+
+	tail->work.function = prv_sink_closure;
+	tail->work.dispose = prv_sink_dispose; // The tail will free the parent task.
+	tail->work.context = task;
+
+	// Sink is a subtask
+	task->num_subtasks = 1;
+
+	// Transfer dependants to sink.
+	task_move_dependants(task, tail);
+
+	// Set the tail.
+	task->tail = tail;
+
+	return tail;
 }
 
 daggle_error_code_t
@@ -53,25 +91,13 @@ daggle_task_create(daggle_node_task_fn work,
 	daggle_node_task_dispose_fn dispose, void* context, char* id,
 	daggle_task_h* out_task)
 {
-	task_t* task = malloc(sizeof(task_t));
-	task->tail = NULL;
-	task->head = NULL;
+	REQUIRE_OUTPUT_PARAMETER(out_task);
 
-	task->num_subtasks = 0;
-	atomic_store(&task->num_pending_subtasks, 1);
+	task_t* task = task_alloc();
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(task);
 
-	dynamic_array_init(0, sizeof(task_t*), &task->dependants);
-	atomic_store(&task->num_pending_dependencies, 0);
-
-	prv_node_task_wrapper_ctx_t* ctx = malloc(sizeof *ctx);
-	ctx->context = context;
-	ctx->function = work;
-	ctx->dispose = dispose;
-	ctx->task = task;
-
-	task->work.function = prv_node_task_wrapper_function;
-	task->work.dispose = prv_node_task_wrapper_dispose;
-	task->work.context = ctx;
+	task_set_node_task(task, work, dispose, context);
+	task->id = id;
 
 	*out_task = task;
 
@@ -83,8 +109,8 @@ daggle_task_create(daggle_node_task_fn work,
 daggle_error_code_t
 prv_task_depend_flat(task_t* task, task_t* dependency)
 {
+	RETURN_IF_ERROR(task_add_dependant(dependency, task));
 	atomic_fetch_add(&task->num_pending_dependencies, 1);
-	dynamic_array_push(&dependency->dependants, &task);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
@@ -115,32 +141,10 @@ daggle_task_add_subgraph(daggle_task_h task, daggle_task_h* tasks,
 	task_t* task_impl = task;
 	daggle_task_h* tasks_impl = tasks;
 
-	task_t* tail = NULL;
-	if (task_impl->tail == NULL) {
-		tail = malloc(sizeof(task_t));
-		tail->tail = NULL;
-		tail->head = task_impl;
-
-		tail->num_subtasks = 0;
-		atomic_store(&tail->num_pending_subtasks, 1);
-
-		tail->work.function = prv_sink_closure;
-		tail->work.dispose
-			= prv_sink_dispose; // The tail will free the parent task.
-		tail->work.context = task_impl;
-		atomic_store(&tail->num_pending_dependencies, 0);
-
-		// Sink is a subtask
-		task_impl->num_subtasks = 1;
-
-		// Transfer dependants to sink.
-		tail->dependants = task_impl->dependants;
-		dynamic_array_init(0, sizeof(task_t*), &task_impl->dependants);
-
-		// Set the tail.
-		task_impl->tail = tail;
-	} else {
-		tail = task_impl->tail;
+	task_t* tail = task_impl->tail;
+	if (tail == NULL) {
+		tail = task_create_sink(task_impl);
+		REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(tail);
 	}
 
 	task_impl->num_subtasks += num_tasks;
@@ -155,7 +159,7 @@ daggle_task_add_subgraph(daggle_task_h task, daggle_task_h* tasks,
 		// Make tail a dependant of every task.
 		// Only tasks without dependants have to be the dependencies of the
 		// sink.
-		if (subtask->dependants.length == 0) {
+		if (subtask->num_dependants == 0) {
 			prv_task_depend_flat(tail, subtask);
 		}
 
@@ -167,7 +171,62 @@ daggle_task_add_subgraph(daggle_task_h task, daggle_task_h* tasks,
 		}
 
 		subtask->head = task_impl;
+
+		// Subtasks created at run time are as urgent as their parent.
+		if (subtask->priority == 0) {
+			subtask->priority = task_impl->priority;
+		}
 	}
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
+
+daggle_error_code_t
+daggle_task_is_cancelled(daggle_task_h task, bool* out_cancelled)
+{
+	REQUIRE_PARAMETER(task);
+	REQUIRE_OUTPUT_PARAMETER(out_cancelled);
+
+	// Tasks which have not run yet have not inherited the execution.
+	task_t* task_impl = task;
+	while (!task_impl->execution && task_impl->head) {
+		task_impl = task_impl->head;
+	}
+
+	*out_cancelled = task_impl->execution
+		&& execution_is_cancelled(task_impl->execution);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_task_alloc(daggle_task_h task, uint64_t size, uint64_t alignment,
+	void** out_data)
+{
+	REQUIRE_PARAMETER(task);
+	REQUIRE_OUTPUT_PARAMETER(out_data);
+
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		LOG(LOG_TAG_ERROR, "Alignment is not a power of two");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	// Tasks which have not run yet have not inherited the context.
+	task_t* task_impl = task;
+	while (!task_impl->execution_context && task_impl->head) {
+		task_impl = task_impl->head;
+	}
+
+	if (!task_impl->execution_context) {
+		LOG(LOG_TAG_ERROR, "Task is not part of a graph execution");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	void* memory = execution_context_alloc_scratch(
+		task_impl->execution_context, size, alignment);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(memory);
+
+	*out_data = memory;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
@@ -0,0 +1,217 @@
+#include "utility/arena.h"
+
+#include "stdbool.h"
+#include "stdlib.h"
+#include "utility/return_macro.h"
+
+#define ARENA_MIN_CHUNK_CAPACITY (16ull * 1024)
+#define ARENA_MAX_CHUNK_CAPACITY (1024ull * 1024)
+
+// Larger sizes and alignments are refused, so growing a chunk for them can't
+// overflow.
+#define ARENA_MAX_SIZE (UINT64_MAX / 4)
+
+void
+arena_init(arena_t* arena)
+{
+	ASSERT_PARAMETER(arena);
+
+	arena->chunks = NULL;
+	arena->next_capacity = ARENA_MIN_CHUNK_CAPACITY;
+}
+
+void
+arena_destroy(arena_t* arena)
+{
+	ASSERT_PARAMETER(arena);
+
+	arena_chunk_t* chunk = arena->chunks;
+	while (chunk) {
+		arena_chunk_t* next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	arena->chunks = NULL;
+	arena->next_capacity = ARENA_MIN_CHUNK_CAPACITY;
+}
+
+void
+arena_reset(arena_t* arena)
+{
+	ASSERT_PARAMETER(arena);
+
+	arena_chunk_t* chunk = arena->chunks;
+	if (!chunk) {
+		return;
+	}
+
+	arena_chunk_t* older = chunk->next;
+	while (older) {
+		arena_chunk_t* next = older->next;
+		free(older);
+		older = next;
+	}
+
+	chunk->next = NULL;
+	atomic_store_explicit(&chunk->used, 0, memory_order_relaxed);
+}
+
+void*
+arena_alloc(arena_t* arena, uint64_t size)
+{
+	ASSERT_PARAMETER(arena);
+
+	if (size > ARENA_MAX_SIZE) {
+		return NULL;
+	}
+
+	// Keep every allocation aligned for any type.
+	size = (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+
+	return arena_alloc_aligned(arena, size, alignof(max_align_t));
+}
+
+// Chunk data is aligned for any type, larger alignments may need padding up
+// to the alignment.
+uint64_t
+prv_arena_extra_capacity(uint64_t alignment)
+{
+	return alignment > alignof(max_align_t) ? alignment : 0;
+}
+
+bool
+prv_arena_is_size_valid(uint64_t size, uint64_t extra)
+{
+	return extra <= ARENA_MAX_SIZE && size <= ARENA_MAX_SIZE - extra;
+}
+
+// Make a chunk of at least the capacity the newest one, NULL if it can't be
+// allocated.
+arena_chunk_t*
+prv_arena_add_chunk(arena_t* arena, uint64_t min_capacity)
+{
+	uint64_t capacity = arena->next_capacity;
+	while (capacity < min_capacity) {
+		capacity *= 2;
+	}
+
+	arena_chunk_t* chunk = malloc(sizeof *chunk + capacity);
+	if (!chunk) {
+		return NULL;
+	}
+
+	chunk->next
+		= atomic_load_explicit(&arena->chunks, memory_order_relaxed);
+	chunk->capacity = capacity;
+	atomic_init(&chunk->used, 0);
+
+	// Small graphs stay small, large ones take few chunks.
+	if (arena->next_capacity < ARENA_MAX_CHUNK_CAPACITY) {
+		arena->next_capacity *= 2;
+	}
+
+	// Concurrent allocations see the chunk only once it is set up.
+	atomic_store_explicit(&arena->chunks, chunk, memory_order_release);
+
+	return chunk;
+}
+
+uint64_t
+prv_arena_padding(arena_chunk_t* chunk, uint64_t used, uint64_t alignment)
+{
+	uintptr_t top = (uintptr_t)(chunk->data + used);
+	return ((top + alignment - 1) & ~(uintptr_t)(alignment - 1)) - top;
+}
+
+void*
+arena_alloc_aligned(arena_t* arena, uint64_t size, uint64_t alignment)
+{
+	ASSERT_PARAMETER(arena);
+	ASSERT_TRUE(alignment > 0 && (alignment & (alignment - 1)) == 0,
+		"alignment is not a power of two");
+
+	uint64_t extra = prv_arena_extra_capacity(alignment);
+	if (!prv_arena_is_size_valid(size, extra)) {
+		return NULL;
+	}
+
+	arena_chunk_t* chunk
+		= atomic_load_explicit(&arena->chunks, memory_order_relaxed);
+
+	uint64_t used = 0;
+	uint64_t padding = 0;
+	if (chunk) {
+		used = atomic_load_explicit(&chunk->used, memory_order_relaxed);
+		padding = prv_arena_padding(chunk, used, alignment);
+	}
+
+	if (!chunk || chunk->capacity - used < size + padding) {
+		chunk = prv_arena_add_chunk(arena, size + extra);
+		if (!chunk) {
+			return NULL;
+		}
+
+		used = 0;
+		padding = prv_arena_padding(chunk, 0, alignment);
+	}
+
+	atomic_store_explicit(&chunk->used, used + padding + size,
+		memory_order_relaxed);
+
+	return chunk->data + used + padding;
+}
+
+void*
+arena_alloc_concurrent(arena_t* arena, pthread_mutex_t* lock, uint64_t size,
+	uint64_t alignment)
+{
+	ASSERT_PARAMETER(arena);
+	ASSERT_PARAMETER(lock);
+	ASSERT_TRUE(alignment > 0 && (alignment & (alignment - 1)) == 0,
+		"alignment is not a power of two");
+
+	uint64_t extra = prv_arena_extra_capacity(alignment);
+	if (!prv_arena_is_size_valid(size, extra)) {
+		return NULL;
+	}
+
+	// Claims are kept aligned for any type, so only larger alignments pad.
+	uint64_t claim
+		= (size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+	claim += extra;
+
+	while (true) {
+		arena_chunk_t* chunk
+			= atomic_load_explicit(&arena->chunks, memory_order_acquire);
+
+		if (chunk) {
+			uint64_t used
+				= atomic_load_explicit(&chunk->used, memory_order_relaxed);
+
+			while (chunk->capacity - used >= claim) {
+				if (atomic_compare_exchange_weak_explicit(&chunk->used, &used,
+						used + claim, memory_order_relaxed,
+						memory_order_relaxed)) {
+					return chunk->data + used
+						+ prv_arena_padding(chunk, used, alignment);
+				}
+			}
+		}
+
+		// The chunk is full, the first thread to get here adds the next one.
+		pthread_mutex_lock(lock);
+
+		bool is_added = true;
+		if (atomic_load_explicit(&arena->chunks, memory_order_relaxed)
+			== chunk) {
+			is_added = prv_arena_add_chunk(arena, claim) != NULL;
+		}
+
+		pthread_mutex_unlock(lock);
+
+		if (!is_added) {
+			return NULL;
+		}
+	}
+}
@@ -0,0 +1,161 @@
+#include "atom_table.h"
+
+#include "stdlib.h"
+#include "string.h"
+#include "utility/hash.h"
+#include "utility/return_macro.h"
+
+#define ATOM_TABLE_INITIAL_SLOTS 256
+
+daggle_error_code_t
+atom_table_init(atom_table_t* table)
+{
+	ASSERT_PARAMETER(table);
+
+	table->slots = calloc(ATOM_TABLE_INITIAL_SLOTS, sizeof(atom_t*));
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(table->slots);
+
+	table->num_slots = ATOM_TABLE_INITIAL_SLOTS;
+	table->num_atoms = 0;
+
+	pthread_mutex_init(&table->lock, NULL);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+atom_table_destroy(atom_table_t* table)
+{
+	ASSERT_PARAMETER(table);
+
+	for (uint64_t i = 0; i < table->num_slots; ++i) {
+		free(table->slots[i]);
+	}
+
+	free(table->slots);
+	table->slots = NULL;
+	table->num_slots = 0;
+	table->num_atoms = 0;
+
+	pthread_mutex_destroy(&table->lock);
+}
+
+// Slot holding the atom of the name, or the empty slot where it would go.
+atom_t**
+prv_atom_table_probe(atom_table_t* table, const char* name, uint32_t hash)
+{
+	uint64_t mask = table->num_slots - 1;
+
+	for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+		atom_t** slot = table->slots + i;
+		if (!*slot || ((*slot)->hash == hash && !strcmp((*slot)->name, name))) {
+			return slot;
+		}
+	}
+}
+
+daggle_error_code_t
+prv_atom_table_grow(atom_table_t* table)
+{
+	uint64_t num_slots = table->num_slots * 2;
+
+	atom_t** slots = calloc(num_slots, sizeof(atom_t*));
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(slots);
+
+	atom_t** old_slots = table->slots;
+	uint64_t old_num_slots = table->num_slots;
+
+	table->slots = slots;
+	table->num_slots = num_slots;
+
+	for (uint64_t i = 0; i < old_num_slots; ++i) {
+		atom_t* atom = old_slots[i];
+		if (atom) {
+			*prv_atom_table_probe(table, atom->name, atom->hash) = atom;
+		}
+	}
+
+	free(old_slots);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+prv_atom_write(const atom_t* atom, name_with_hash_t* out_atom)
+{
+	out_atom->name = atom->name;
+	out_atom->hash = atom->hash;
+}
+
+bool
+atom_table_find(atom_table_t* table, const char* name,
+	name_with_hash_t* out_atom)
+{
+	ASSERT_PARAMETER(table);
+	ASSERT_PARAMETER(name);
+	ASSERT_OUTPUT_PARAMETER(out_atom);
+
+	uint32_t hash = fnv1a_32(name);
+
+	pthread_mutex_lock(&table->lock);
+
+	atom_t* atom = *prv_atom_table_probe(table, name, hash);
+	if (atom) {
+		prv_atom_write(atom, out_atom);
+	}
+
+	pthread_mutex_unlock(&table->lock);
+
+	return atom != NULL;
+}
+
+daggle_error_code_t
+atom_table_intern(atom_table_t* table, const char* name,
+	name_with_hash_t* out_atom)
+{
+	ASSERT_PARAMETER(table);
+	ASSERT_PARAMETER(name);
+	ASSERT_OUTPUT_PARAMETER(out_atom);
+
+	uint32_t hash = fnv1a_32(name);
+
+	pthread_mutex_lock(&table->lock);
+
+	atom_t** slot = prv_atom_table_probe(table, name, hash);
+	if (*slot) {
+		prv_atom_write(*slot, out_atom);
+		pthread_mutex_unlock(&table->lock);
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	// Keep at most half of the slots in use, so probes stay short.
+	if ((table->num_atoms + 1) * 2 > table->num_slots) {
+		daggle_error_code_t error = prv_atom_table_grow(table);
+		if (error != DAGGLE_SUCCESS) {
+			pthread_mutex_unlock(&table->lock);
+			RETURN_STATUS(error);
+		}
+
+		slot = prv_atom_table_probe(table, name, hash);
+	}
+
+	uint64_t len = strlen(name);
+
+	atom_t* atom = malloc(sizeof *atom + len + 1);
+	if (!atom) {
+		pthread_mutex_unlock(&table->lock);
+		RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+	}
+
+	atom->hash = hash;
+	memcpy(atom->name, name, len + 1);
+
+	*slot = atom;
+	++table->num_atoms;
+
+	prv_atom_write(atom, out_atom);
+
+	pthread_mutex_unlock(&table->lock);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
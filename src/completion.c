@@ -0,0 +1,100 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "utility/completion.h"
+
+#include "time.h"
+#include "utility/return_macro.h"
+
+void
+completion_init(completion_t* completion)
+{
+	ASSERT_PARAMETER(completion);
+
+	pthread_mutex_init(&completion->lock, NULL);
+
+	// Timed waits use the monotonic clock, so they are not affected by changes
+	// to the system time.
+	pthread_condattr_t attributes;
+	pthread_condattr_init(&attributes);
+	pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+	pthread_cond_init(&completion->condition, &attributes);
+	pthread_condattr_destroy(&attributes);
+
+	atomic_init(&completion->done, false);
+}
+
+void
+completion_destroy(completion_t* completion)
+{
+	ASSERT_PARAMETER(completion);
+
+	pthread_cond_destroy(&completion->condition);
+	pthread_mutex_destroy(&completion->lock);
+}
+
+void
+completion_signal(completion_t* completion)
+{
+	ASSERT_PARAMETER(completion);
+
+	pthread_mutex_lock(&completion->lock);
+	atomic_store_explicit(&completion->done, true, memory_order_release);
+	pthread_cond_broadcast(&completion->condition);
+	pthread_mutex_unlock(&completion->lock);
+}
+
+bool
+completion_poll(completion_t* completion)
+{
+	ASSERT_PARAMETER(completion);
+
+	return atomic_load_explicit(&completion->done, memory_order_acquire);
+}
+
+void
+completion_wait(completion_t* completion)
+{
+	ASSERT_PARAMETER(completion);
+
+	// Skip the lock if already done.
+	if (completion_poll(completion)) {
+		return;
+	}
+
+	pthread_mutex_lock(&completion->lock);
+	while (!atomic_load_explicit(&completion->done, memory_order_relaxed)) {
+		pthread_cond_wait(&completion->condition, &completion->lock);
+	}
+	pthread_mutex_unlock(&completion->lock);
+}
+
+bool
+completion_wait_for(completion_t* completion, uint64_t timeout_ns)
+{
+	ASSERT_PARAMETER(completion);
+
+	if (completion_poll(completion)) {
+		return true;
+	}
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+	uint64_t nanoseconds = deadline.tv_nsec + timeout_ns % 1000000000ull;
+	deadline.tv_sec += timeout_ns / 1000000000ull + nanoseconds / 1000000000ull;
+	deadline.tv_nsec = nanoseconds % 1000000000ull;
+
+	pthread_mutex_lock(&completion->lock);
+	while (!atomic_load_explicit(&completion->done, memory_order_relaxed)) {
+		if (pthread_cond_timedwait(&completion->condition, &completion->lock,
+				&deadline)
+			!= 0) {
+			// Timed out, but it might have been signaled just before.
+			break;
+		}
+	}
+	bool done = atomic_load_explicit(&completion->done, memory_order_relaxed);
+	pthread_mutex_unlock(&completion->lock);
+
+	return done;
+}
@@ -3,6 +3,7 @@
 #include "instance.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
 #include "utility/return_macro.h"
 
 void
@@ -14,6 +15,9 @@ data_container_init(daggle_instance_h instance, data_container_t* container)
 	container->info = NULL;
 	container->data = NULL;
 	container->instance = instance;
+	container->shared = NULL;
+	container->is_scratch = false;
+	container->is_inline = false;
 }
 
 void
@@ -41,6 +45,9 @@ data_container_init_generate(daggle_instance_h instance,
 	container->info = info;
 	container->data = default_value_data;
 	container->instance = instance;
+	container->shared = NULL;
+	container->is_scratch = false;
+	container->is_inline = false;
 }
 
 void
@@ -48,18 +55,43 @@ data_container_destroy(data_container_t* container)
 {
 	ASSERT_PARAMETER(container);
 
-	// If the value or the type info is null -> skip.
-	if (!data_container_has_value(container)) {
-		return;
+	// Call the destructor on the data, scratch data goes with the arena, and
+	// inline data with the container. Shared data goes with the last
+	// reference. If the value or the type info is null -> skip.
+	if (container->shared) {
+		shared_value_release(container->shared);
+	} else if (data_container_has_value(container) && !container->is_scratch
+		&& !container->is_inline) {
+		type_info_release_data(container->info, container->instance,
+			container->data);
 	}
 
-	// Call the destructor on the data.
-	daggle_data_free(container->instance, container->info->name_hash.name,
-		container->data);
+	data_container_forget(container);
+}
+
+void
+data_container_forget(data_container_t* container)
+{
+	ASSERT_PARAMETER(container);
 
 	// Set the contents to nullptr.
 	container->data = NULL;
 	container->info = NULL;
+	container->shared = NULL;
+	container->is_scratch = false;
+	container->is_inline = false;
+}
+
+// Overwrite the old data, which has been destroyed.
+void
+prv_data_container_set(data_container_t* container, type_info_t* type,
+	void* data)
+{
+	container->data = data;
+	container->info = type;
+	container->shared = NULL;
+	container->is_scratch = false;
+	container->is_inline = false;
 }
 
 void
@@ -71,9 +103,87 @@ data_container_replace(data_container_t* container, type_info_t* type,
 	// If there is existing data, delete it first.
 	data_container_destroy(container);
 
-	// Overwrite the old data.
-	container->data = data;
-	container->info = type;
+	prv_data_container_set(container, type, data);
+
+	// Values of shared types are always held by reference, so consumers can
+	// share them without racing to convert the value. Without the memory for
+	// the reference it is held as is, and copied for every consumer.
+	if (data && type && type->is_shared) {
+		container->shared
+			= shared_value_create(container->instance, type, data);
+	}
+}
+
+void
+data_container_replace_scratch(data_container_t* container, type_info_t* type,
+	void* data)
+{
+	ASSERT_PARAMETER(container);
+
+	data_container_destroy(container);
+
+	prv_data_container_set(container, type, data);
+	container->is_scratch = true;
+}
+
+void
+data_container_replace_shared(data_container_t* container,
+	shared_value_t* value)
+{
+	ASSERT_PARAMETER(container);
+	ASSERT_PARAMETER(value);
+
+	data_container_destroy(container);
+
+	prv_data_container_set(container, value->info, value->data);
+	container->shared = value;
+}
+
+void
+data_container_replace_inline(data_container_t* container, type_info_t* type,
+	const void* data)
+{
+	ASSERT_PARAMETER(container);
+	ASSERT_PARAMETER(type);
+	ASSERT_PARAMETER(data);
+	ASSERT_TRUE(type->is_inline, "type is not stored inline");
+
+	data_container_destroy(container);
+
+	memmove(container->inline_data, data, type->size);
+
+	prv_data_container_set(container, type, container->inline_data);
+	container->is_inline = true;
+}
+
+void
+data_container_replace_copy(data_container_t* container, type_info_t* type,
+	const void* data)
+{
+	ASSERT_PARAMETER(container);
+	ASSERT_PARAMETER(type);
+
+	if (data && type->is_inline) {
+		data_container_replace_inline(container, type, data);
+		return;
+	}
+
+	void* copy = NULL;
+	if (data) {
+		type->cloner(container->instance, data, &copy);
+	}
+
+	data_container_replace(container, type, copy);
+}
+
+void
+data_container_rebase(data_container_t* container)
+{
+	ASSERT_PARAMETER(container);
+
+	if (container->is_inline) {
+		container->data = container->inline_data;
+	}
 }
 
 bool
@@ -0,0 +1,697 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "disk_cache.h"
+
+#include "dirent.h"
+#include "errno.h"
+#include "fcntl.h"
+#include "instance.h"
+#include "node.h"
+#include "ports.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "unistd.h"
+#include "utility/log_macro.h"
+#include "utility/return_macro.h"
+
+// "DGLC" in a little-endian file, files of the other byte order don't match.
+#define DISK_CACHE_MAGIC 0x434c4744u
+#define DISK_CACHE_VERSION 1u
+#define DISK_CACHE_EXTENSION ".dgc"
+
+// Names and data start at multiples of this, so deserializers may read the
+// mapped data in place.
+#define DISK_CACHE_ALIGNMENT 8
+
+// Going over the limit evicts down to this percentage of it.
+#define DISK_CACHE_LOW_WATER_PERCENT 90
+
+// The node type follows the header, then the outputs. Names are stored with
+// their terminator.
+typedef struct disk_cache_header_s {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint64_t num_outputs;
+	uint64_t node_type_len;
+} disk_cache_header_t;
+
+// Followed by the name, the type and the serialized data of the output.
+typedef struct disk_cache_output_s {
+	uint64_t name_len;
+	uint64_t type_len;
+	uint64_t data_len;
+} disk_cache_output_t;
+
+typedef struct prv_disk_cache_file_s {
+	char* name;
+	uint64_t size;
+	struct timespec modified;
+} prv_disk_cache_file_t;
+
+typedef struct prv_disk_cache_buffer_s {
+	unsigned char* data;
+	uint64_t length;
+	uint64_t capacity;
+} prv_disk_cache_buffer_t;
+
+typedef struct prv_disk_cache_reader_s {
+	const unsigned char* at;
+	uint64_t remaining;
+} prv_disk_cache_reader_t;
+
+uint64_t
+prv_disk_cache_align(uint64_t value)
+{
+	uint64_t mask = DISK_CACHE_ALIGNMENT - 1;
+
+	return (value + mask) & ~mask;
+}
+
+// Path of a file in the directory, freed by the caller.
+char*
+prv_disk_cache_path(const disk_cache_t* cache, const char* name)
+{
+	uint64_t len = strlen(cache->directory) + 1 + strlen(name) + 1;
+
+	char* path = malloc(len);
+	if (path) {
+		snprintf(path, len, "%s/%s", cache->directory, name);
+	}
+
+	return path;
+}
+
+// Name of the file of a key, in a buffer of at least 32 characters.
+void
+prv_disk_cache_name(uint64_t key, char* out_name)
+{
+	snprintf(out_name, 32, "%016llx" DISK_CACHE_EXTENSION,
+		(unsigned long long)key);
+}
+
+bool
+prv_disk_cache_is_entry(const char* name)
+{
+	uint64_t len = strlen(name);
+	uint64_t ext_len = strlen(DISK_CACHE_EXTENSION);
+
+	return len > ext_len && !strcmp(name + len - ext_len, DISK_CACHE_EXTENSION);
+}
+
+void
+prv_disk_cache_free_files(prv_disk_cache_file_t* files, uint64_t num_files)
+{
+	for (uint64_t i = 0; i < num_files; ++i) {
+		free(files[i].name);
+	}
+
+	free(files);
+}
+
+// List the cached results in the directory and sum up their sizes.
+daggle_error_code_t
+prv_disk_cache_scan(const disk_cache_t* cache,
+	prv_disk_cache_file_t** out_files, uint64_t* out_num_files,
+	uint64_t* out_num_bytes)
+{
+	DIR* dir = opendir(cache->directory);
+	if (!dir) {
+		LOG_FMT(LOG_TAG_ERROR, "Can't open cache directory %s",
+			cache->directory);
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	prv_disk_cache_file_t* files = NULL;
+	uint64_t num_files = 0;
+	uint64_t capacity = 0;
+	uint64_t num_bytes = 0;
+
+	struct dirent* dirent;
+	while ((dirent = readdir(dir))) {
+		if (!prv_disk_cache_is_entry(dirent->d_name)) {
+			continue;
+		}
+
+		char* path = prv_disk_cache_path(cache, dirent->d_name);
+		struct stat st;
+		bool is_found = path && stat(path, &st) == 0 && S_ISREG(st.st_mode);
+		free(path);
+
+		// Removed by another process meanwhile.
+		if (!is_found) {
+			continue;
+		}
+
+		if (num_files == capacity) {
+			capacity = capacity > 0 ? capacity * 2 : 64;
+
+			prv_disk_cache_file_t* grown
+				= realloc(files, sizeof(prv_disk_cache_file_t) * capacity);
+			if (!grown) {
+				closedir(dir);
+				prv_disk_cache_free_files(files, num_files);
+				RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+			}
+
+			files = grown;
+		}
+
+		char* name = strdup(dirent->d_name);
+		if (!name) {
+			closedir(dir);
+			prv_disk_cache_free_files(files, num_files);
+			RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+		}
+
+		files[num_files].name = name;
+		files[num_files].size = (uint64_t)st.st_size;
+		files[num_files].modified = st.st_mtim;
+		++num_files;
+
+		num_bytes += (uint64_t)st.st_size;
+	}
+
+	closedir(dir);
+
+	*out_files = files;
+	*out_num_files = num_files;
+	*out_num_bytes = num_bytes;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+int
+prv_disk_cache_compare_modified(const void* a, const void* b)
+{
+	const prv_disk_cache_file_t* file_a = a;
+	const prv_disk_cache_file_t* file_b = b;
+
+	if (file_a->modified.tv_sec != file_b->modified.tv_sec) {
+		return file_a->modified.tv_sec < file_b->modified.tv_sec ? -1 : 1;
+	}
+
+	return (file_a->modified.tv_nsec > file_b->modified.tv_nsec)
+		- (file_a->modified.tv_nsec < file_b->modified.tv_nsec);
+}
+
+// Remove the files modified longest ago until the rest fit in the low-water
+// mark, so the next few writes don't each scan the directory again. Must hold
+// the lock.
+void
+prv_disk_cache_evict(disk_cache_t* cache)
+{
+	uint64_t low_water = cache->max_bytes
+		- cache->max_bytes / 100 * (100 - DISK_CACHE_LOW_WATER_PERCENT);
+
+	prv_disk_cache_file_t* files;
+	uint64_t num_files;
+	uint64_t num_bytes;
+	if (prv_disk_cache_scan(cache, &files, &num_files, &num_bytes)
+		!= DAGGLE_SUCCESS) {
+		return;
+	}
+
+	qsort(files, num_files, sizeof(prv_disk_cache_file_t),
+		prv_disk_cache_compare_modified);
+
+	for (uint64_t i = 0; i < num_files && num_bytes > low_water; ++i) {
+		char* path = prv_disk_cache_path(cache, files[i].name);
+
+		if (path && unlink(path) == 0) {
+			num_bytes -= files[i].size;
+			atomic_fetch_add_explicit(&cache->evictions, 1,
+				memory_order_relaxed);
+		}
+
+		free(path);
+	}
+
+	prv_disk_cache_free_files(files, num_files);
+
+	cache->num_bytes = num_bytes;
+}
+
+daggle_error_code_t
+disk_cache_init(const char* directory, uint64_t max_bytes,
+	daggle_cache_eviction_t eviction, disk_cache_t* cache)
+{
+	ASSERT_PARAMETER(cache);
+
+	cache->directory = NULL;
+	cache->max_bytes = max_bytes;
+	cache->eviction = eviction;
+	cache->num_bytes = 0;
+
+	atomic_init(&cache->sequence, 0);
+	atomic_init(&cache->hits, 0);
+	atomic_init(&cache->writes, 0);
+	atomic_init(&cache->evictions, 0);
+
+	pthread_mutex_init(&cache->lock, NULL);
+
+	if (!directory) {
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+		LOG_FMT(LOG_TAG_ERROR, "Can't create cache directory %s", directory);
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	cache->directory = strdup(directory);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(cache->directory);
+
+	prv_disk_cache_file_t* files;
+	uint64_t num_files;
+	RETURN_IF_ERROR(
+		prv_disk_cache_scan(cache, &files, &num_files, &cache->num_bytes));
+	prv_disk_cache_free_files(files, num_files);
+
+	// The limit may have been lowered since the last process.
+	if (cache->max_bytes > 0 && cache->num_bytes > cache->max_bytes) {
+		prv_disk_cache_evict(cache);
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+disk_cache_destroy(disk_cache_t* cache)
+{
+	ASSERT_PARAMETER(cache);
+
+	free(cache->directory);
+	cache->directory = NULL;
+
+	pthread_mutex_destroy(&cache->lock);
+}
+
+bool
+disk_cache_is_enabled(const disk_cache_t* cache)
+{
+	ASSERT_PARAMETER(cache);
+
+	return cache->directory != NULL;
+}
+
+// Take the next len bytes, padded to the alignment, or NULL if past the end.
+const unsigned char*
+prv_disk_cache_read(prv_disk_cache_reader_t* reader, uint64_t len)
+{
+	uint64_t padded = prv_disk_cache_align(len);
+	if (padded < len || padded > reader->remaining) {
+		return NULL;
+	}
+
+	const unsigned char* at = reader->at;
+	reader->at += padded;
+	reader->remaining -= padded;
+
+	return at;
+}
+
+// Take a terminated string of len bytes, including the terminator.
+const char*
+prv_disk_cache_read_string(prv_disk_cache_reader_t* reader, uint64_t len)
+{
+	const char* string = (const char*)prv_disk_cache_read(reader, len);
+
+	if (!string || len == 0 || string[len - 1] != '\0') {
+		return NULL;
+	}
+
+	return string;
+}
+
+typedef struct prv_disk_cache_loaded_s {
+	port_t* port;
+	type_info_t* info;
+	const unsigned char* data;
+	uint64_t data_len;
+
+	// Set when loading, NULL if the port isn't in the context.
+	void* value;
+} prv_disk_cache_loaded_t;
+
+// Find the outputs of a mapped file. Fails if the file is malformed, belongs
+// to another node type, or one of the outputs or types doesn't exist.
+bool
+prv_disk_cache_parse(daggle_instance_h instance, uint64_t key, node_t* node,
+	const unsigned char* bytes, uint64_t size,
+	prv_disk_cache_loaded_t** out_outputs, uint64_t* out_num_outputs)
+{
+	prv_disk_cache_reader_t reader = { .at = bytes, .remaining = size };
+
+	const unsigned char* header_bytes
+		= prv_disk_cache_read(&reader, sizeof(disk_cache_header_t));
+	if (!header_bytes) {
+		return false;
+	}
+
+	disk_cache_header_t header;
+	memcpy(&header, header_bytes, sizeof header);
+
+	if (header.magic != DISK_CACHE_MAGIC
+		|| header.version != DISK_CACHE_VERSION || header.key != key
+		|| header.num_outputs > size / sizeof(disk_cache_output_t)) {
+		return false;
+	}
+
+	const char* node_type
+		= prv_disk_cache_read_string(&reader, header.node_type_len);
+	if (!node_type || strcmp(node_type, node->info->name_hash.name)) {
+		return false;
+	}
+
+	prv_disk_cache_loaded_t* outputs
+		= malloc(sizeof(prv_disk_cache_loaded_t) * (header.num_outputs + 1));
+	if (!outputs) {
+		return false;
+	}
+
+	resource_container_t* res
+		= &((instance_t*)instance)->plugin_manager.res;
+
+	for (uint64_t i = 0; i < header.num_outputs; ++i) {
+		const unsigned char* output_bytes
+			= prv_disk_cache_read(&reader, sizeof(disk_cache_output_t));
+		if (!output_bytes) {
+			free(outputs);
+			return false;
+		}
+
+		disk_cache_output_t output;
+		memcpy(&output, output_bytes, sizeof output);
+
+		const char* name = prv_disk_cache_read_string(&reader, output.name_len);
+		const char* type = prv_disk_cache_read_string(&reader, output.type_len);
+		const unsigned char* data
+			= prv_disk_cache_read(&reader, output.data_len);
+
+		port_t* port = name ? node_get_port_by_name(node, name) : NULL;
+
+		type_info_t* info = NULL;
+		if (type) {
+			resource_container_get_type(res, type, &info);
+		}
+
+		if (!data || !port || port->port_variant != DAGGLE_PORT_OUTPUT
+			|| !info) {
+			free(outputs);
+			return false;
+		}
+
+		outputs[i].port = port;
+		outputs[i].info = info;
+		outputs[i].data = data;
+		outputs[i].data_len = output.data_len;
+	}
+
+	*out_outputs = outputs;
+	*out_num_outputs = header.num_outputs;
+
+	return true;
+}
+
+bool
+disk_cache_load(disk_cache_t* cache, daggle_instance_h instance, uint64_t key,
+	struct node_s* node, execution_context_t* context)
+{
+	ASSERT_PARAMETER(cache);
+	ASSERT_PARAMETER(instance);
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(context);
+
+	char name[32];
+	prv_disk_cache_name(key, name);
+
+	char* path = prv_disk_cache_path(cache, name);
+	if (!path) {
+		return false;
+	}
+
+	int fd = open(path, O_RDONLY);
+	free(path);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		close(fd);
+		return false;
+	}
+
+	uint64_t size = (uint64_t)st.st_size;
+	void* bytes = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (bytes == MAP_FAILED) {
+		close(fd);
+		return false;
+	}
+
+	prv_disk_cache_loaded_t* outputs;
+	uint64_t num_outputs;
+	bool is_found = prv_disk_cache_parse(instance, key, node, bytes, size,
+		&outputs, &num_outputs);
+
+	if (is_found) {
+		// Deserialize every output before replacing any, so a result that
+		// can't be read is a miss instead of a partial hit.
+		for (uint64_t i = 0; i < num_outputs; ++i) {
+			prv_disk_cache_loaded_t* output = outputs + i;
+			output->value = NULL;
+
+			if (!is_found
+				|| !execution_context_get_port(context, output->port)) {
+				continue;
+			}
+
+			output->info->deserializer(instance, output->data,
+				output->data_len, &output->value);
+
+			is_found = output->value != NULL;
+		}
+
+		for (uint64_t i = 0; i < num_outputs; ++i) {
+			prv_disk_cache_loaded_t* output = outputs + i;
+			if (!output->value) {
+				continue;
+			}
+
+			if (is_found) {
+				context_port_t* state
+					= execution_context_get_port(context, output->port);
+				data_container_replace(&state->value, output->info,
+					output->value);
+			} else {
+				output->info->freer(instance, output->value);
+			}
+		}
+
+		free(outputs);
+	}
+
+	if (is_found) {
+		// The modification time orders the files for eviction.
+		if (cache->eviction == DAGGLE_CACHE_EVICTION_LEAST_RECENTLY_USED) {
+			futimens(fd, NULL);
+		}
+
+		atomic_fetch_add_explicit(&cache->hits, 1, memory_order_relaxed);
+	}
+
+	munmap(bytes, size);
+	close(fd);
+
+	return is_found;
+}
+
+bool
+prv_disk_cache_append(prv_disk_cache_buffer_t* buffer, const void* data,
+	uint64_t len)
+{
+	uint64_t padded = prv_disk_cache_align(len);
+
+	if (buffer->length + padded > buffer->capacity) {
+		uint64_t capacity = buffer->capacity > 0 ? buffer->capacity : 256;
+		while (capacity < buffer->length + padded) {
+			capacity *= 2;
+		}
+
+		unsigned char* grown = realloc(buffer->data, capacity);
+		if (!grown) {
+			return false;
+		}
+
+		buffer->data = grown;
+		buffer->capacity = capacity;
+	}
+
+	memcpy(buffer->data + buffer->length, data, len);
+	memset(buffer->data + buffer->length + len, 0, padded - len);
+	buffer->length += padded;
+
+	return true;
+}
+
+// Serialize the outputs with a value in the format read by
+// prv_disk_cache_parse.
+bool
+prv_disk_cache_serialize(daggle_instance_h instance, uint64_t key,
+	node_t* node, execution_context_t* context,
+	prv_disk_cache_buffer_t* buffer)
+{
+	const char* node_type = node->info->name_hash.name;
+
+	disk_cache_header_t header = {
+		.magic = DISK_CACHE_MAGIC,
+		.version = DISK_CACHE_VERSION,
+		.key = key,
+		.num_outputs = 0,
+		.node_type_len = strlen(node_type) + 1,
+	};
+
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t* port = node_get_port_by_index(node, i);
+		data_container_t* container = port_get_container(port, context);
+
+		if (port->port_variant == DAGGLE_PORT_OUTPUT && container
+			&& data_container_has_value(container)) {
+			++header.num_outputs;
+		}
+	}
+
+	if (!prv_disk_cache_append(buffer, &header, sizeof header)
+		|| !prv_disk_cache_append(buffer, node_type, header.node_type_len)) {
+		return false;
+	}
+
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t* port = node_get_port_by_index(node, i);
+		if (port->port_variant != DAGGLE_PORT_OUTPUT) {
+			continue;
+		}
+
+		data_container_t* container = port_get_container(port, context);
+		if (!container || !data_container_has_value(container)) {
+			continue;
+		}
+
+		const char* name = port->name_hash.name;
+		const char* type = container->info->name_hash.name;
+
+		unsigned char* data = NULL;
+		uint64_t data_len = 0;
+		container->info->serializer(instance, container->data, &data,
+			&data_len);
+
+		disk_cache_output_t output = {
+			.name_len = strlen(name) + 1,
+			.type_len = strlen(type) + 1,
+			.data_len = data_len,
+		};
+
+		bool is_appended
+			= prv_disk_cache_append(buffer, &output, sizeof output)
+			&& prv_disk_cache_append(buffer, name, output.name_len)
+			&& prv_disk_cache_append(buffer, type, output.type_len)
+			&& prv_disk_cache_append(buffer, data, data_len);
+
+		free(data);
+
+		if (!is_appended) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+prv_disk_cache_write_file(const char* path, const unsigned char* data,
+	uint64_t len)
+{
+	int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0666);
+	if (fd < 0) {
+		return false;
+	}
+
+	while (len > 0) {
+		ssize_t written = write(fd, data, len);
+		if (written < 0 && errno == EINTR) {
+			continue;
+		}
+
+		if (written <= 0) {
+			close(fd);
+			return false;
+		}
+
+		data += written;
+		len -= (uint64_t)written;
+	}
+
+	return close(fd) == 0;
+}
+
+void
+disk_cache_store(disk_cache_t* cache, daggle_instance_h instance,
+	uint64_t key, struct node_s* node, execution_context_t* context)
+{
+	ASSERT_PARAMETER(cache);
+	ASSERT_PARAMETER(instance);
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(context);
+
+	prv_disk_cache_buffer_t buffer = { 0 };
+	if (!prv_disk_cache_serialize(instance, key, node, context, &buffer)) {
+		free(buffer.data);
+		return;
+	}
+
+	char name[32];
+	prv_disk_cache_name(key, name);
+
+	// Unique among processes by the pid, and among threads by the sequence.
+	char temporary_name[96];
+	snprintf(temporary_name, sizeof temporary_name, "%s.%ld.%llu.tmp", name,
+		(long)getpid(),
+		(unsigned long long)atomic_fetch_add(&cache->sequence, 1));
+
+	char* path = prv_disk_cache_path(cache, name);
+	char* temporary_path = prv_disk_cache_path(cache, temporary_name);
+
+	bool is_written = path && temporary_path
+		&& prv_disk_cache_write_file(temporary_path, buffer.data,
+			buffer.length)
+		&& rename(temporary_path, path) == 0;
+
+	if (!is_written && temporary_path) {
+		unlink(temporary_path);
+	}
+
+	free(path);
+	free(temporary_path);
+	free(buffer.data);
+
+	if (!is_written) {
+		LOG(LOG_TAG_WARN, "Failed to write a result to the cache directory");
+		return;
+	}
+
+	atomic_fetch_add_explicit(&cache->writes, 1, memory_order_relaxed);
+
+	pthread_mutex_lock(&cache->lock);
+
+	cache->num_bytes += buffer.length;
+	if (cache->max_bytes > 0 && cache->num_bytes > cache->max_bytes) {
+		prv_disk_cache_evict(cache);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+}
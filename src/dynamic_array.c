@@ -84,7 +84,7 @@ dynamic_array_remove(dynamic_array_t* array, uint64_t index)
 		unsigned char* src
 			= (unsigned char*)array->data + ((index + 1) * array->stride);
 		uint64_t bytes_to_move = (array->length - index - 1) * array->stride;
-		memcpy(dest, src, bytes_to_move);
+		memmove(dest, src, bytes_to_move);
 	}
 
 	array->length--;
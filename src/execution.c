@@ -0,0 +1,108 @@
+#include "execution.h"
+
+#include "executor.h"
+#include "stdlib.h"
+#include "utility/clock.h"
+#include "utility/return_macro.h"
+
+daggle_error_code_t
+execution_create(struct executor* executor,
+	daggle_execution_callback_fn callback, void* callback_data,
+	execution_t** out_execution)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_OUTPUT_PARAMETER(out_execution);
+
+	execution_t* execution = malloc(sizeof *execution);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(execution);
+
+	completion_init(&execution->completion);
+
+	execution->executor = executor;
+
+	execution->callback = callback;
+	execution->callback_data = callback_data;
+
+	// One reference for the caller, one for the root task.
+	atomic_init(&execution->references, 2);
+
+	atomic_init(&execution->cancelled, false);
+	atomic_init(&execution->deadline_ns, 0);
+	atomic_init(&execution->skipped, false);
+
+	execution->created_ns = clock_now_ns();
+
+	*out_execution = execution;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+execution_release(execution_t* execution)
+{
+	ASSERT_PARAMETER(execution);
+
+	if (atomic_fetch_sub(&execution->references, 1) != 1) {
+		return;
+	}
+
+	completion_destroy(&execution->completion);
+	free(execution);
+}
+
+void
+execution_complete(execution_t* execution)
+{
+	ASSERT_PARAMETER(execution);
+
+	executor_record_execution(execution->executor,
+		clock_now_ns() - execution->created_ns);
+
+	// The callback runs before the waiters are woken up, so the results it
+	// produces are visible once a wait returns.
+	if (execution->callback) {
+		execution->callback(execution, execution->callback_data);
+	}
+
+	completion_signal(&execution->completion);
+
+	execution_release(execution);
+}
+
+void
+execution_cancel(execution_t* execution)
+{
+	ASSERT_PARAMETER(execution);
+
+	atomic_store_explicit(&execution->cancelled, true, memory_order_relaxed);
+}
+
+void
+execution_set_deadline(execution_t* execution, uint64_t timeout_ns)
+{
+	ASSERT_PARAMETER(execution);
+
+	uint64_t deadline = timeout_ns ? clock_now_ns() + timeout_ns : 0;
+	atomic_store_explicit(&execution->deadline_ns, deadline,
+		memory_order_relaxed);
+}
+
+bool
+execution_is_cancelled(execution_t* execution)
+{
+	ASSERT_PARAMETER(execution);
+
+	if (atomic_load_explicit(&execution->cancelled, memory_order_relaxed)) {
+		return true;
+	}
+
+	// The clock is only read when a deadline has been set.
+	uint64_t deadline
+		= atomic_load_explicit(&execution->deadline_ns, memory_order_relaxed);
+	if (deadline == 0 || clock_now_ns() < deadline) {
+		return false;
+	}
+
+	atomic_store_explicit(&execution->cancelled, true, memory_order_relaxed);
+	return true;
+}
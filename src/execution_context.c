@@ -0,0 +1,327 @@
+#include "execution_context.h"
+
+#include "executor.h"
+#include "graph.h"
+#include "node.h"
+#include "ports.h"
+#include "stdlib.h"
+#include "utility/return_macro.h"
+
+void
+execution_context_init(struct graph_s* graph, execution_context_t* context)
+{
+	ASSERT_PARAMETER(graph);
+	ASSERT_PARAMETER(context);
+
+	context->graph = graph;
+	context->ports = NULL;
+	context->num_ports = 0;
+	context->nodes = NULL;
+	context->num_nodes = 0;
+	atomic_init(&context->executing, false);
+
+	pthread_mutex_init(&context->scratch_lock, NULL);
+	arena_init(&context->scratch);
+}
+
+void
+execution_context_destroy(execution_context_t* context)
+{
+	ASSERT_PARAMETER(context);
+
+	for (uint64_t i = 0; i < context->num_ports; ++i) {
+		data_container_destroy(&context->ports[i].value);
+	}
+
+	free(context->ports);
+	context->ports = NULL;
+	context->num_ports = 0;
+
+	free(context->nodes);
+	context->nodes = NULL;
+	context->num_nodes = 0;
+
+	arena_destroy(&context->scratch);
+	pthread_mutex_destroy(&context->scratch_lock);
+}
+
+// Make room for every node slot handed out by the graph. New nodes have never
+// run in the context.
+daggle_error_code_t
+prv_execution_context_reserve_nodes(execution_context_t* context)
+{
+	uint64_t num_nodes = context->graph->num_node_slots;
+
+	if (num_nodes <= context->num_nodes) {
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	context_node_t* nodes
+		= realloc(context->nodes, sizeof(context_node_t) * num_nodes);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(nodes);
+
+	for (uint64_t i = context->num_nodes; i < num_nodes; ++i) {
+		nodes[i].version = 0;
+		nodes[i].is_dirty = true;
+	}
+
+	context->nodes = nodes;
+	context->num_nodes = num_nodes;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// Make room for every port and node slot handed out by the graph.
+daggle_error_code_t
+prv_execution_context_reserve(execution_context_t* context)
+{
+	RETURN_IF_ERROR(prv_execution_context_reserve_nodes(context));
+
+	graph_t* graph = context->graph;
+	uint64_t num_ports = graph->num_port_slots;
+
+	if (num_ports <= context->num_ports) {
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	context_port_t* ports
+		= realloc(context->ports, sizeof(context_port_t) * num_ports);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(ports);
+
+	// Inline values moved along with the ports.
+	for (uint64_t i = 0; i < context->num_ports; ++i) {
+		data_container_rebase(&ports[i].value);
+	}
+
+	for (uint64_t i = context->num_ports; i < num_ports; ++i) {
+		data_container_init(graph->instance, &ports[i].value);
+		atomic_init(&ports[i].num_pending_accesses, 0);
+		ports[i].has_spent_access = false;
+	}
+
+	context->ports = ports;
+	context->num_ports = num_ports;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// Whether anything was allocated since the last reset.
+bool
+prv_execution_context_has_scratch(execution_context_t* context)
+{
+	arena_chunk_t* chunk = atomic_load_explicit(&context->scratch.chunks,
+		memory_order_relaxed);
+
+	return chunk
+		&& atomic_load_explicit(&chunk->used, memory_order_relaxed) > 0;
+}
+
+// Forget the values in the arena, which is about to be reset.
+void
+prv_execution_context_drop_scratch(execution_context_t* context)
+{
+	for (uint64_t i = 0; i < context->num_ports; ++i) {
+		data_container_t* container = &context->ports[i].value;
+		if (container->is_scratch) {
+			data_container_destroy(container);
+		}
+	}
+}
+
+daggle_error_code_t
+execution_context_begin(execution_context_t* context)
+{
+	ASSERT_PARAMETER(context);
+
+	if (atomic_exchange(&context->executing, true)) {
+		RETURN_STATUS(DAGGLE_ERROR_OBJECT_LOCKED);
+	}
+
+	daggle_error_code_t error = prv_execution_context_reserve(context);
+	if (error != DAGGLE_SUCCESS) {
+		atomic_store(&context->executing, false);
+		RETURN_STATUS(error);
+	}
+
+	// Values left in the arena by the last execution are replaced by this one.
+	if (prv_execution_context_has_scratch(context)) {
+		prv_execution_context_drop_scratch(context);
+		arena_reset(&context->scratch);
+	}
+
+	graph_t* graph = context->graph;
+	atomic_fetch_add(&graph->num_executions, 1);
+
+	// Reset port counters.
+	for (uint64_t i = 0; i < graph->nodes.length; ++i) {
+		node_t** nodeelem = dynamic_array_at(&graph->nodes, i);
+		node_t* node = *nodeelem;
+
+		for (uint64_t j = 0; j < node->ports.length; ++j) {
+			port_t* port = node_get_port_by_index(node, j);
+			context_port_t* state = context->ports + port->slot;
+
+			if (port->port_variant == DAGGLE_PORT_INPUT) {
+				state->has_spent_access = false;
+			} else if (port->port_variant == DAGGLE_PORT_OUTPUT) {
+				atomic_store(&state->num_pending_accesses,
+					port->variant.output.links.length);
+			}
+		}
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// Values of inputs, and of outputs kept for the next execution, are copied
+// out of the arena. The rest are read at most until the next execution
+// replaces them, and stay in the arena until then.
+void
+prv_execution_context_promote_scratch(execution_context_t* context)
+{
+	graph_t* graph = context->graph;
+
+	for (uint64_t i = 0; i < graph->nodes.length; ++i) {
+		node_t** nodeelem = dynamic_array_at(&graph->nodes, i);
+		node_t* node = *nodeelem;
+
+		for (uint64_t j = 0; j < node->ports.length; ++j) {
+			port_t* port = node_get_port_by_index(node, j);
+			data_container_t* container = &context->ports[port->slot].value;
+			if (!container->is_scratch) {
+				continue;
+			}
+
+			if (port->port_variant == DAGGLE_PORT_OUTPUT
+				&& !execution_context_is_output_retained(port)) {
+				continue;
+			}
+
+			if (!data_container_has_value(container)) {
+				data_container_destroy(container);
+				continue;
+			}
+
+			data_container_replace_copy(container, container->info,
+				container->data);
+		}
+	}
+}
+
+void
+execution_context_end(execution_context_t* context)
+{
+	ASSERT_PARAMETER(context);
+
+	if (prv_execution_context_has_scratch(context)) {
+		prv_execution_context_promote_scratch(context);
+	}
+
+	atomic_fetch_sub(&context->graph->num_executions, 1);
+	atomic_store(&context->executing, false);
+}
+
+void*
+execution_context_alloc_scratch(execution_context_t* context, uint64_t size,
+	uint64_t alignment)
+{
+	ASSERT_PARAMETER(context);
+
+	return arena_alloc_concurrent(&context->scratch, &context->scratch_lock,
+		size, alignment);
+}
+
+void
+execution_context_finish_access(execution_context_t* context,
+	struct port_s* output)
+{
+	ASSERT_PARAMETER(context);
+	ASSERT_PARAMETER(output);
+
+	context_port_t* state = execution_context_get_port(context, output);
+	if (!state) {
+		return;
+	}
+
+	if (atomic_fetch_sub(&state->num_pending_accesses, 1) != 1) {
+		return;
+	}
+
+	// Nothing reads the value in this execution anymore, and unless it is kept
+	// for the next one, nothing will.
+	node_t* owner = output->owner;
+	graph_t* graph = owner->graph;
+	if (graph->instance->release_consumed_values
+		&& !execution_context_is_output_retained(output)) {
+		data_container_destroy(&state->value);
+	}
+}
+
+context_port_t*
+execution_context_get_port(execution_context_t* context, struct port_s* port)
+{
+	ASSERT_PARAMETER(context);
+	ASSERT_PARAMETER(port);
+
+	if (port->slot >= context->num_ports
+		&& prv_execution_context_reserve(context) != DAGGLE_SUCCESS) {
+		return NULL;
+	}
+
+	return context->ports + port->slot;
+}
+
+context_node_t*
+execution_context_get_node(execution_context_t* context, struct node_s* node)
+{
+	ASSERT_PARAMETER(context);
+	ASSERT_PARAMETER(node);
+
+	if (node->slot >= context->num_nodes
+		&& prv_execution_context_reserve_nodes(context) != DAGGLE_SUCCESS) {
+		return NULL;
+	}
+
+	return context->nodes + node->slot;
+}
+
+bool
+execution_context_is_node_dirty(execution_context_t* context,
+	struct node_s* node)
+{
+	ASSERT_PARAMETER(context);
+	ASSERT_PARAMETER(node);
+
+	context_node_t* state = execution_context_get_node(context, node);
+
+	return !state || state->is_dirty || state->version != node->version
+		|| node->is_volatile;
+}
+
+bool
+execution_context_is_output_retained(struct port_s* output)
+{
+	ASSERT_PARAMETER(output);
+
+	node_t* owner = output->owner;
+	graph_t* graph = owner->graph;
+
+	return graph->instance->incremental_execution && !owner->is_volatile;
+}
+
+execution_context_t*
+execution_context_resolve(struct port_s* port)
+{
+	ASSERT_PARAMETER(port);
+
+	node_t* owner = port->owner;
+	graph_t* graph = owner->graph;
+
+	task_t* task = executor_get_current_task();
+	if (task && task->execution_context
+		&& task->execution_context->graph == graph) {
+		return task->execution_context;
+	}
+
+	return &graph->default_context;
+}
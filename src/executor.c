@@ -1,18 +1,211 @@
 #include "executor.h"
 
+#include "sched.h"
 #include "stdatomic.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "string.h"
+#include "utility/clock.h"
 #include "utility/return_macro.h"
+#include "utility/topology.h"
 
-#define NUM_THREADS 2
+// Initial capacity of the per-worker deques, they grow when needed.
+#define WORKER_DEQUE_CAPACITY 256
+
+// The worker running on the current thread, NULL outside of workers.
+static _Thread_local worker_t* prv_current_worker = NULL;
+
+// The task being run on the current thread, NULL outside of tasks.
+static _Thread_local task_t* prv_current_task = NULL;
+
+// Pool shared by the threads outside of the executors, such as the ones
+// building task graphs before submitting them.
+static task_pool_t prv_external_pool;
+static pthread_mutex_t prv_external_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t prv_external_pool_once = PTHREAD_ONCE_INIT;
+
+void
+prv_external_pool_init(void)
+{
+	task_pool_init(&prv_external_pool);
+}
+
+void
+prv_worker_statistics_init(worker_statistics_t* statistics)
+{
+	atomic_init(&statistics->num_executed, 0);
+	atomic_init(&statistics->num_enqueued, 0);
+	atomic_init(&statistics->num_dequeued, 0);
+	atomic_init(&statistics->num_stolen, 0);
+	atomic_init(&statistics->max_queue_depth, 0);
+	atomic_init(&statistics->parked_ns, 0);
+
+	histogram_init(&statistics->run_time);
+	histogram_init(&statistics->queue_wait);
+}
+
+void
+task_init(task_t* task)
+{
+	task->work.function = NULL;
+	task->work.dispose = NULL;
+	task->work.context = NULL;
+
+	task->head = NULL;
+	task->tail = NULL;
+	task->num_subtasks = 0;
+	task->execution = NULL;
+	atomic_init(&task->next, NULL);
+
+	task->node_function = NULL;
+	task->node_dispose = NULL;
+	task->node_context = NULL;
+
+	task->dependants = task->inline_dependants;
+	task->num_dependants = 0;
+	task->dependants_capacity = TASK_INLINE_DEPENDANTS;
+
+	atomic_init(&task->num_pending_subtasks, 1);
+	atomic_init(&task->num_pending_dependencies, 0);
+	task->priority = 0;
+	task->execution_context = NULL;
+	task->id = NULL;
+	task->ready_ns = 0;
+}
+
+task_t*
+task_alloc(void)
+{
+	worker_t* worker = prv_current_worker;
+
+	task_t* task;
+	if (worker) {
+		task = task_pool_alloc(&worker->pool);
+	} else {
+		pthread_once(&prv_external_pool_once, prv_external_pool_init);
+
+		pthread_mutex_lock(&prv_external_pool_lock);
+		task = task_pool_alloc(&prv_external_pool);
+		pthread_mutex_unlock(&prv_external_pool_lock);
+	}
+
+	if (!task) {
+		return NULL;
+	}
+
+	task_init(task);
+
+	return task;
+}
+
+// Free the memory of an already disposed task.
+void
+prv_task_release(task_t* task)
+{
+	// Tasks of plans are reset by their plan instead.
+	if (!task->pool) {
+		return;
+	}
+
+	execution_t* execution = task->execution;
+	task_t* head = task->head;
+
+	if (task_owns_dependants(task)) {
+		free(task->dependants);
+	}
+
+	worker_t* worker = prv_current_worker;
+	task_pool_t* local = worker ? &worker->pool : NULL;
+
+	if (task->pool == local) {
+		task_pool_free_local(local, task);
+	} else if (!worker && task->pool == &prv_external_pool) {
+		pthread_mutex_lock(&prv_external_pool_lock);
+		task_pool_free_local(&prv_external_pool, task);
+		pthread_mutex_unlock(&prv_external_pool_lock);
+	} else {
+		task_pool_free_remote(local, task);
+	}
+
+	// A root task is freed last, after every subtask has been disposed.
+	if (execution && !head) {
+		execution_complete(execution);
+	}
+}
 
 void
 task_free(task_t* task)
 {
 	void_closure_dispose(&task->work);
-	dynamic_array_destroy(&task->dependants);
-	free(task);
+	prv_task_release(task);
+}
+
+daggle_error_code_t
+task_add_dependant(task_t* task, task_t* dependant)
+{
+	ASSERT_PARAMETER(task);
+	ASSERT_PARAMETER(dependant);
+
+	if (task->num_dependants == task->dependants_capacity) {
+		uint32_t capacity = task->num_dependants * 2;
+		if (capacity < TASK_INLINE_DEPENDANTS) {
+			capacity = TASK_INLINE_DEPENDANTS;
+		}
+
+		// Borrowed lists are copied on the first change.
+		task_t** dependants;
+		if (!task_owns_dependants(task)) {
+			dependants = malloc(sizeof(task_t*) * capacity);
+			REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(dependants);
+			memcpy(dependants, task->dependants,
+				sizeof(task_t*) * task->num_dependants);
+		} else {
+			dependants
+				= realloc(task->dependants, sizeof(task_t*) * capacity);
+			REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(dependants);
+		}
+
+		task->dependants = dependants;
+		task->dependants_capacity = capacity;
+	}
+
+	task->dependants[task->num_dependants++] = dependant;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+task_move_dependants(task_t* from, task_t* to)
+{
+	ASSERT_PARAMETER(from);
+	ASSERT_PARAMETER(to);
+	ASSERT_TRUE(to->num_dependants == 0, "Target already has dependants");
+
+	if (task_owns_dependants(to)) {
+		free(to->dependants);
+	}
+
+	if (from->dependants == from->inline_dependants) {
+		memcpy(to->inline_dependants, from->inline_dependants,
+			sizeof(task_t*) * from->num_dependants);
+		to->dependants = to->inline_dependants;
+	} else {
+		to->dependants = from->dependants;
+	}
+
+	to->num_dependants = from->num_dependants;
+	to->dependants_capacity = from->dependants_capacity;
+
+	from->dependants = from->inline_dependants;
+	from->num_dependants = 0;
+	from->dependants_capacity = TASK_INLINE_DEPENDANTS;
+}
+
+bool
+task_owns_dependants(const task_t* task)
+{
+	return task->dependants != task->inline_dependants
+		&& task->dependants_capacity > 0;
 }
 
 void
@@ -27,68 +220,855 @@ prv_propagate_progress(task_t* task)
 	}
 }
 
-typedef struct prv_worker_ctx {
-	executor_t* executor;
-	uint64_t id;
-} prv_worker_ctx_t;
+// Wake up a parked worker, if there are any.
+void
+prv_executor_wake_one(executor_t* executor)
+{
+	// Pairs with the fence in prv_worker_park. Either the parking worker sees
+	// the pushed task, or this sees the parking worker.
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&executor->num_sleeping, memory_order_relaxed)
+		== 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&executor->park_lock);
+	pthread_cond_signal(&executor->park_condition);
+	pthread_mutex_unlock(&executor->park_lock);
+}
+
+// Find the group of the NUMA node the calling thread is running on.
+worker_group_t*
+prv_executor_get_local_group(executor_t* executor)
+{
+	if (executor->num_groups == 1) {
+		return executor->groups;
+	}
+
+	uint64_t cpu = topology_get_current_cpu();
+	if (cpu >= executor->num_cpu_nodes) {
+		return executor->groups;
+	}
+
+	uint64_t node = executor->cpu_nodes[cpu];
+	for (uint64_t i = 0; i < executor->num_groups; ++i) {
+		if (executor->groups[i].node == node) {
+			return executor->groups + i;
+		}
+	}
+
+	return executor->groups;
+}
+
+// Add to a counter of the calling worker, which is the only one writing it.
+void
+prv_worker_count(_Atomic(uint64_t)* counter, uint64_t amount)
+{
+	uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+	atomic_store_explicit(counter, value + amount, memory_order_relaxed);
+}
+
+// Submit a task whose ready time is already set. Never fails, a worker whose
+// deque can't grow submits to the queue of its group instead, which doesn't
+// allocate.
+void
+prv_executor_push(executor_t* executor, task_t* task)
+{
+	worker_t* worker = prv_current_worker;
+
+	if (worker && worker->executor == executor
+		&& ws_deque_push(&worker->deque, task) == DAGGLE_SUCCESS) {
+		worker_statistics_t* statistics = &worker->statistics;
+		prv_worker_count(&statistics->num_enqueued, 1);
+
+		uint64_t depth = ws_deque_size(&worker->deque);
+		if (depth > atomic_load_explicit(&statistics->max_queue_depth,
+				memory_order_relaxed)) {
+			atomic_store_explicit(&statistics->max_queue_depth, depth,
+				memory_order_relaxed);
+		}
+	} else {
+		worker_group_t* group = prv_executor_get_local_group(executor);
+		task_queue_enqueue(&group->queue, task);
+
+		atomic_fetch_add_explicit(&executor->num_submitted, 1,
+			memory_order_relaxed);
+	}
+
+	prv_executor_wake_one(executor);
+}
+
+daggle_error_code_t
+executor_submit(executor_t* executor, task_t* task)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_PARAMETER(task);
+
+	if (executor->is_timing) {
+		task->ready_ns = clock_now_ns();
+	}
+
+	prv_executor_push(executor, task);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+uint64_t
+prv_worker_next_random(worker_t* worker)
+{
+	uint64_t x = worker->steal_seed;
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	worker->steal_seed = x;
+	return x;
+}
+
+// Try to steal from the workers of a group, starting from a random victim to
+// spread the contention.
+task_t*
+prv_worker_steal_from_group(worker_t* worker, worker_group_t* group)
+{
+	executor_t* executor = worker->executor;
+	uint64_t num_workers = group->num_workers;
+
+	uint64_t start = prv_worker_next_random(worker) % num_workers;
+	for (uint64_t i = 0; i < num_workers; ++i) {
+		uint64_t index = group->first_worker + (start + i) % num_workers;
+		worker_t* victim = executor->workers + index;
+
+		if (victim == worker) {
+			continue;
+		}
+
+		task_t* task = ws_deque_steal(&victim->deque);
+		if (task) {
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+task_t*
+prv_worker_take_task(worker_t* worker, bool* out_stolen)
+{
+	executor_t* executor = worker->executor;
+	worker_group_t* group = worker->group;
+
+	*out_stolen = false;
+
+	// Newest local task first, its data is most likely still in cache.
+	task_t* task = ws_deque_pop(&worker->deque);
+	if (task) {
+		return task;
+	}
+
+	// Then work available on the same NUMA node.
+	task = task_queue_try_dequeue(&group->queue);
+	if (task) {
+		return task;
+	}
+
+	*out_stolen = true;
+
+	task = prv_worker_steal_from_group(worker, group);
+	if (task) {
+		return task;
+	}
+
+	// Finally, work on the other nodes.
+	for (uint64_t i = 0; i < executor->num_groups; ++i) {
+		worker_group_t* other = executor->groups + i;
+		if (other == group) {
+			continue;
+		}
+
+		*out_stolen = false;
+
+		task = task_queue_try_dequeue(&other->queue);
+		if (task) {
+			return task;
+		}
+
+		*out_stolen = true;
+
+		task = prv_worker_steal_from_group(worker, other);
+		if (task) {
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+task_t*
+prv_worker_find_task(worker_t* worker)
+{
+	bool is_stolen;
+	task_t* task = prv_worker_take_task(worker, &is_stolen);
+
+	if (task) {
+		prv_worker_count(&worker->statistics.num_dequeued, 1);
+
+		if (is_stolen) {
+			prv_worker_count(&worker->statistics.num_stolen, 1);
+		}
+	}
+
+	return task;
+}
+
+bool
+prv_executor_has_work(executor_t* executor)
+{
+	for (uint64_t i = 0; i < executor->num_groups; ++i) {
+		if (!task_queue_is_empty(&executor->groups[i].queue)) {
+			return true;
+		}
+	}
+
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		if (ws_deque_size(&executor->workers[i].deque) > 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+prv_worker_park(worker_t* worker)
+{
+	executor_t* executor = worker->executor;
+
+	pthread_mutex_lock(&executor->park_lock);
+
+	// Announce the intent to sleep before checking for work one last time.
+	// A task pushed after the check will see the announcement and signal.
+	atomic_fetch_add_explicit(&executor->num_sleeping, 1,
+		memory_order_seq_cst);
+	atomic_thread_fence(memory_order_seq_cst);
+
+	if (!atomic_load(&executor->halt) && !prv_executor_has_work(executor)) {
+		uint64_t start = clock_now_ns();
+		pthread_cond_wait(&executor->park_condition, &executor->park_lock);
+		prv_worker_count(&worker->statistics.parked_ns, clock_now_ns() - start);
+	}
+
+	atomic_fetch_sub_explicit(&executor->num_sleeping, 1,
+		memory_order_seq_cst);
+
+	pthread_mutex_unlock(&executor->park_lock);
+}
+
+// Record the times of a task which has run.
+void
+prv_worker_record_run(worker_t* worker, task_t* task, uint64_t start_ns,
+	uint64_t end_ns)
+{
+	// Tasks made ready before the timing saw them have no queue time.
+	uint64_t wait_ns = 0;
+	if (task->ready_ns > 0 && task->ready_ns < start_ns) {
+		wait_ns = start_ns - task->ready_ns;
+	}
+
+	histogram_record_exclusive(&worker->statistics.run_time,
+		end_ns - start_ns);
+	histogram_record_exclusive(&worker->statistics.queue_wait, wait_ns);
+
+	if (trace_buffer_is_enabled(&worker->trace)) {
+		trace_event_t event;
+		event.id = task->id;
+		event.task = task;
+		event.parent = task->head;
+		event.ready_ns = task->ready_ns;
+		event.start_ns = start_ns;
+		event.end_ns = end_ns;
+
+		trace_buffer_record(&worker->trace, &event);
+	}
+}
+
+// Run a task and release its dependants. Returns a dependant which became
+// ready and should be run next by the same worker, if any.
+task_t*
+prv_worker_run_one(worker_t* worker, task_t* task)
+{
+	executor_t* executor = worker->executor;
+
+	// The head has run before any of its subtasks.
+	if (task->head) {
+		if (!task->execution) {
+			task->execution = task->head->execution;
+		}
+
+		if (!task->execution_context) {
+			task->execution_context = task->head->execution_context;
+		}
+	}
+
+	// Tasks may run nested when a worker waits, restore the outer one after.
+	task_t* outer_task = prv_current_task;
+	prv_current_task = task;
+
+	// A task of a cancelled execution is skipped, but otherwise finished as
+	// usual, so that the disposes run and the execution completes.
+	execution_t* execution = task->execution;
+	if (execution && execution_is_cancelled(execution)) {
+		atomic_store_explicit(&execution->skipped, true, memory_order_relaxed);
+	} else if (executor->is_timing) {
+		uint64_t start = clock_now_ns();
+		void_closure_call(&task->work);
+		prv_worker_record_run(worker, task, start, clock_now_ns());
+	} else {
+		void_closure_call(&task->work);
+	}
+
+	prv_worker_count(&worker->statistics.num_executed, 1);
+
+	prv_propagate_progress(task);
+
+	// If the task has a subgraph, the task is freed in the tail dispose. Tasks
+	// of plans are never freed, the next run may reuse them as soon as the
+	// last dependant is released.
+	bool has_subgraph = task->tail != NULL;
+	bool is_released = !has_subgraph && task->pool;
+
+	// Dispose before releasing the dependants, so everything a task leaves
+	// behind is finished by the time its dependants, and eventually the waiter
+	// of the execution, run.
+	if (!has_subgraph) {
+		void_closure_dispose(&task->work);
+	}
+
+	prv_current_task = outer_task;
+
+	// Releasing the last dependant may complete the subgraph of this task,
+	// which frees it. The dependant list must not be read after that.
+	uint64_t num_dependants = task->num_dependants;
+	task_t** dependants = task->dependants;
+
+	// Release in ascending priority. The deque pops the last pushed task
+	// first, so the highest priority ready task is run next, either inline or
+	// from the deque.
+	task_t* continuation = NULL;
+	uint64_t ready_ns = 0;
+	for (uint64_t i = num_dependants; i-- > 0;) {
+		task_t* tk = dependants[i];
+
+		if (atomic_fetch_sub(&tk->num_pending_dependencies, 1) != 1) {
+			continue;
+		}
+
+		if (executor->is_timing) {
+			if (ready_ns == 0) {
+				ready_ns = clock_now_ns();
+			}
+
+			tk->ready_ns = ready_ns;
+		}
+
+		if (!executor->inline_continuation) {
+			prv_executor_push(executor, tk);
+			continue;
+		}
+
+		if (continuation) {
+			prv_executor_push(executor, continuation);
+		}
+
+		continuation = tk;
+	}
+
+	if (is_released) {
+		prv_task_release(task);
+	}
+
+	return continuation;
+}
+
+void
+prv_worker_run_task(worker_t* worker, task_t* task)
+{
+	// Follow the chain of continuations without going through the deque.
+	while (task) {
+		task = prv_worker_run_one(worker, task);
+	}
+}
 
 void*
 prv_worker_thread(void* context)
 {
-	prv_worker_ctx_t* context_impl = context;
-	executor_t* executor = context_impl->executor;
+	worker_t* worker = context;
+	executor_t* executor = worker->executor;
 
-	while (!executor->halt) {
-		task_t* task;
-		ts_llist_queue_dequeue(&executor->queue, &executor->halt,
-			(void**)&task);
+	prv_current_worker = worker;
+
+	if (worker->num_cpus > 0) {
+		topology_pin_thread(pthread_self(), worker->cpus, worker->num_cpus);
+	}
+
+	while (!atomic_load(&executor->halt)) {
+		task_t* task = prv_worker_find_task(worker);
 
-		// Continue if the task is NULL (null enqueued or no tasks available)
 		if (!task) {
+			prv_worker_park(worker);
 			continue;
 		}
 
-		// Call the task work function.
-		void_closure_call(&task->work);
+		prv_worker_run_task(worker, task);
+	}
+
+	// Hand the batched tasks back before the other pools are destroyed.
+	task_pool_flush(&worker->pool);
+
+	prv_current_worker = NULL;
 
-		prv_propagate_progress(task);
+	return NULL;
+}
 
-		for (uint64_t i = 0; i < task->dependants.length; ++i) {
-			task_t** tkelem = dynamic_array_at(&task->dependants, i);
-			task_t* tk = *tkelem;
+// Collect the distinct NUMA nodes in the order of their first CPU.
+uint64_t
+prv_executor_collect_nodes(executor_t* executor, uint64_t* out_nodes)
+{
+	uint64_t num_nodes = 0;
 
-			if (atomic_fetch_sub(&tk->num_pending_dependencies, 1) == 1) {
-				ts_llist_queue_enqueue(&executor->queue, tk);
+	for (uint64_t cpu = 0; cpu < executor->num_cpu_nodes; ++cpu) {
+		uint64_t node = executor->cpu_nodes[cpu];
+		if (node == TOPOLOGY_NO_NODE) {
+			continue;
+		}
+
+		bool is_new = true;
+		for (uint64_t i = 0; i < num_nodes; ++i) {
+			if (out_nodes[i] == node) {
+				is_new = false;
+				break;
 			}
 		}
 
-		// If the task has a subgraph, the task is freed in the tail dispose.
-		if (!task->tail) {
-			task_free(task);
+		if (is_new) {
+			out_nodes[num_nodes++] = node;
 		}
 	}
 
-	free(context_impl);
+	return num_nodes;
+}
 
-	return NULL;
+task_t*
+executor_get_current_task(void)
+{
+	return prv_current_task;
+}
+
+void
+executor_wait(executor_t* executor, completion_t* completion)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_PARAMETER(completion);
+
+	worker_t* worker = prv_current_worker;
+
+	if (!worker || worker->executor != executor) {
+		completion_wait(completion);
+		return;
+	}
+
+	// Blocking a worker could deadlock the pool, help out instead.
+	while (!completion_poll(completion)) {
+		task_t* task = prv_worker_find_task(worker);
+
+		if (task) {
+			prv_worker_run_task(worker, task);
+		} else {
+			sched_yield();
+		}
+	}
+}
+
+bool
+executor_wait_for(executor_t* executor, completion_t* completion,
+	uint64_t timeout_ns)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_PARAMETER(completion);
+
+	worker_t* worker = prv_current_worker;
+
+	if (!worker || worker->executor != executor) {
+		return completion_wait_for(completion, timeout_ns);
+	}
+
+	uint64_t start = clock_now_ns();
+
+	while (!completion_poll(completion)) {
+		if (clock_now_ns() - start >= timeout_ns) {
+			return false;
+		}
+
+		task_t* task = prv_worker_find_task(worker);
+
+		if (task) {
+			prv_worker_run_task(worker, task);
+		} else {
+			sched_yield();
+		}
+	}
+
+	return true;
+}
+
+void
+executor_record_execution(executor_t* executor, uint64_t latency_ns)
+{
+	ASSERT_PARAMETER(executor);
+
+	histogram_record(&executor->execution_latency, latency_ns);
+}
+
+// Add the counters of a worker to the output, the histograms to snapshots.
+void
+prv_worker_add_statistics(worker_t* worker,
+	daggle_worker_statistics_t* statistics, histogram_snapshot_t* run_time,
+	histogram_snapshot_t* queue_wait)
+{
+	worker_statistics_t* counters = &worker->statistics;
+
+	statistics->tasks_executed += atomic_load_explicit(&counters->num_executed,
+		memory_order_relaxed);
+	statistics->tasks_enqueued += atomic_load_explicit(&counters->num_enqueued,
+		memory_order_relaxed);
+	statistics->tasks_dequeued += atomic_load_explicit(&counters->num_dequeued,
+		memory_order_relaxed);
+	statistics->tasks_stolen
+		+= atomic_load_explicit(&counters->num_stolen, memory_order_relaxed);
+	statistics->parked_ns
+		+= atomic_load_explicit(&counters->parked_ns, memory_order_relaxed);
+	statistics->queue_depth += ws_deque_size(&worker->deque);
+
+	uint64_t max_queue_depth = atomic_load_explicit(
+		&counters->max_queue_depth, memory_order_relaxed);
+	if (max_queue_depth > statistics->max_queue_depth) {
+		statistics->max_queue_depth = max_queue_depth;
+	}
+
+	histogram_snapshot_add(run_time, &counters->run_time);
+	histogram_snapshot_add(queue_wait, &counters->queue_wait);
+}
+
+void
+prv_worker_statistics_clear(daggle_worker_statistics_t* statistics)
+{
+	statistics->tasks_executed = 0;
+	statistics->tasks_enqueued = 0;
+	statistics->tasks_dequeued = 0;
+	statistics->tasks_stolen = 0;
+	statistics->queue_depth = 0;
+	statistics->max_queue_depth = 0;
+	statistics->parked_ns = 0;
 }
 
 daggle_error_code_t
-executor_init(executor_t* executor)
+executor_get_statistics(executor_t* executor,
+	daggle_executor_statistics_t* out_statistics)
 {
 	ASSERT_PARAMETER(executor);
+	ASSERT_OUTPUT_PARAMETER(out_statistics);
+
+	// Snapshots hold a few kilobytes each.
+	histogram_snapshot_t* snapshots = malloc(sizeof(histogram_snapshot_t) * 3);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(snapshots);
+
+	histogram_snapshot_t* run_time = snapshots;
+	histogram_snapshot_t* queue_wait = snapshots + 1;
+	histogram_snapshot_t* latency = snapshots + 2;
+
+	histogram_snapshot_init(run_time);
+	histogram_snapshot_init(queue_wait);
+	histogram_snapshot_init(latency);
+
+	daggle_worker_statistics_t* total = &out_statistics->total;
+	prv_worker_statistics_clear(total);
 
-	ts_llist_queue_init(&executor->queue);
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		prv_worker_add_statistics(executor->workers + i, total, run_time,
+			queue_wait);
+	}
 
-	executor->halt = false;
-	executor->workers = malloc(sizeof(pthread_t) * NUM_THREADS);
+	histogram_snapshot_summarize(run_time, &total->run_time);
+	histogram_snapshot_summarize(queue_wait, &total->queue_wait);
 
-	for (uint64_t i = 0; i < NUM_THREADS; ++i) {
-		prv_worker_ctx_t* ctx = malloc(sizeof *ctx);
-		ctx->executor = executor;
-		ctx->id = i;
+	out_statistics->num_workers = executor->num_workers;
+	out_statistics->tasks_submitted
+		= atomic_load_explicit(&executor->num_submitted, memory_order_relaxed);
 
-		pthread_create(executor->workers + i, NULL, &prv_worker_thread, ctx);
+	out_statistics->submission_queue_depth = 0;
+	for (uint64_t i = 0; i < executor->num_groups; ++i) {
+		out_statistics->submission_queue_depth += atomic_load_explicit(
+			&executor->groups[i].queue.size, memory_order_relaxed);
+	}
+
+	histogram_snapshot_add(latency, &executor->execution_latency);
+	histogram_snapshot_summarize(latency, &out_statistics->execution_latency);
+
+	free(snapshots);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+executor_get_worker_statistics(executor_t* executor, uint64_t worker,
+	daggle_worker_statistics_t* out_statistics)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_OUTPUT_PARAMETER(out_statistics);
+	ASSERT_TRUE(worker < executor->num_workers, "No such worker");
+
+	histogram_snapshot_t* snapshots = malloc(sizeof(histogram_snapshot_t) * 2);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(snapshots);
+
+	histogram_snapshot_init(snapshots);
+	histogram_snapshot_init(snapshots + 1);
+
+	prv_worker_statistics_clear(out_statistics);
+	prv_worker_add_statistics(executor->workers + worker, out_statistics,
+		snapshots, snapshots + 1);
+
+	histogram_snapshot_summarize(snapshots, &out_statistics->run_time);
+	histogram_snapshot_summarize(snapshots + 1, &out_statistics->queue_wait);
+
+	free(snapshots);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+executor_write_trace(executor_t* executor, FILE* stream)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_PARAMETER(stream);
+
+	fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", stream);
+
+	bool is_first = true;
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		worker_t* worker = executor->workers + i;
+
+		fprintf(stream,
+			"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0"
+			",\"tid\":%llu,\"args\":{\"name\":\"worker %llu\"}}",
+			is_first ? "" : ",", (unsigned long long)worker->id,
+			(unsigned long long)worker->id);
+		is_first = false;
+
+		trace_buffer_write_chrome(&worker->trace, worker->id,
+			executor->trace_epoch_ns, stream, &is_first);
+	}
+
+	fputs("\n]}\n", stream);
+}
+
+void
+executor_clear_trace(executor_t* executor)
+{
+	ASSERT_PARAMETER(executor);
+
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		trace_buffer_clear(&executor->workers[i].trace);
+	}
+}
+
+// Decide the NUMA node and the CPUs of every worker.
+daggle_error_code_t
+prv_executor_place_workers(executor_t* executor,
+	const daggle_instance_options_t* options, worker_t* workers,
+	uint64_t* out_worker_nodes)
+{
+	uint64_t* nodes = malloc(sizeof(uint64_t) * executor->num_cpu_nodes);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(nodes);
+
+	uint64_t num_nodes = prv_executor_collect_nodes(executor, nodes);
+
+	// Without the topology in sysfs, no CPU is known to exist.
+	if (num_nodes == 0) {
+		nodes[num_nodes++] = 0;
+	}
+
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		worker_t* worker = workers + i;
+		worker->cpus = NULL;
+		worker->num_cpus = 0;
+		out_worker_nodes[i] = 0;
+
+		if (options->cpus && options->num_cpus > 0) {
+			// Explicitly pinned to a single CPU.
+			uint64_t cpu = options->cpus[i % options->num_cpus];
+			if (cpu >= executor->num_cpu_nodes) {
+				LOG_FMT(LOG_TAG_ERROR, "CPU %llu does not exist",
+					(unsigned long long)cpu);
+				free(nodes);
+				RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+			}
+
+			worker->cpus = malloc(sizeof(uint64_t));
+			if (!worker->cpus) {
+				free(nodes);
+				RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+			}
+
+			worker->cpus[0] = cpu;
+			worker->num_cpus = 1;
+
+			if (options->numa_aware
+				&& executor->cpu_nodes[cpu] != TOPOLOGY_NO_NODE) {
+				out_worker_nodes[i] = executor->cpu_nodes[cpu];
+			}
+		} else if (options->numa_aware) {
+			// Spread over the nodes, restricted to the CPUs of the node.
+			uint64_t node = nodes[i % num_nodes];
+			out_worker_nodes[i] = node;
+
+			worker->cpus = malloc(sizeof(uint64_t) * executor->num_cpu_nodes);
+			if (!worker->cpus) {
+				free(nodes);
+				RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+			}
+
+			for (uint64_t cpu = 0; cpu < executor->num_cpu_nodes; ++cpu) {
+				if (executor->cpu_nodes[cpu] == node) {
+					worker->cpus[worker->num_cpus++] = cpu;
+				}
+			}
+		}
+	}
+
+	free(nodes);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// Create the worker groups and store the workers contiguously per group.
+daggle_error_code_t
+prv_executor_group_workers(executor_t* executor, worker_t* placed,
+	const uint64_t* worker_nodes)
+{
+	executor->groups = aligned_alloc(alignof(worker_group_t),
+		sizeof(worker_group_t) * executor->num_workers);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(executor->groups);
+	executor->num_groups = 0;
+
+	uint64_t num_placed = 0;
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		// Skip nodes which already have a group.
+		bool is_grouped = false;
+		for (uint64_t j = 0; j < executor->num_groups; ++j) {
+			if (executor->groups[j].node == worker_nodes[i]) {
+				is_grouped = true;
+				break;
+			}
+		}
+
+		if (is_grouped) {
+			continue;
+		}
+
+		worker_group_t* group = executor->groups + executor->num_groups++;
+		task_queue_init(&group->queue);
+		group->node = worker_nodes[i];
+		group->first_worker = num_placed;
+		group->num_workers = 0;
+
+		for (uint64_t j = i; j < executor->num_workers; ++j) {
+			if (worker_nodes[j] != group->node) {
+				continue;
+			}
+
+			worker_t* worker = executor->workers + num_placed;
+			*worker = placed[j];
+			worker->group = group;
+			worker->id = num_placed;
+
+			group->num_workers++;
+			num_placed++;
+		}
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+executor_init(executor_t* executor, const daggle_instance_options_t* options)
+{
+	ASSERT_PARAMETER(executor);
+	ASSERT_PARAMETER(options);
+
+	atomic_init(&executor->halt, false);
+	executor->inline_continuation = options->inline_continuation;
+	executor->is_tracing = options->trace_capacity > 0;
+	executor->is_timing = options->task_timing || executor->is_tracing;
+	executor->trace_epoch_ns = clock_now_ns();
+	atomic_init(&executor->num_submitted, 0);
+	histogram_init(&executor->execution_latency);
+	atomic_init(&executor->num_sleeping, 0);
+
+	pthread_mutex_init(&executor->park_lock, NULL);
+	pthread_cond_init(&executor->park_condition, NULL);
+
+	executor->num_workers = options->num_threads
+		? options->num_threads
+		: topology_get_num_cpus();
+
+	// Map each CPU to its NUMA node, used to route external submissions.
+	executor->num_cpu_nodes = topology_get_cpu_id_limit();
+	executor->cpu_nodes = malloc(sizeof(uint64_t) * executor->num_cpu_nodes);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(executor->cpu_nodes);
+
+	for (uint64_t cpu = 0; cpu < executor->num_cpu_nodes; ++cpu) {
+		executor->cpu_nodes[cpu]
+			= options->numa_aware ? topology_get_cpu_node(cpu) : 0;
+	}
+
+	// Workers and groups hold cache-line aligned members.
+	executor->workers = aligned_alloc(alignof(worker_t),
+		sizeof(worker_t) * executor->num_workers);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(executor->workers);
+
+	worker_t* placed = aligned_alloc(alignof(worker_t),
+		sizeof(worker_t) * executor->num_workers);
+	uint64_t* worker_nodes = malloc(sizeof(uint64_t) * executor->num_workers);
+
+	daggle_error_code_t error = DAGGLE_ERROR_MEMORY_ALLOCATION;
+	if (placed && worker_nodes) {
+		error = prv_executor_place_workers(executor, options, placed,
+			worker_nodes);
+	}
+
+	if (error == DAGGLE_SUCCESS) {
+		error = prv_executor_group_workers(executor, placed, worker_nodes);
+	}
+
+	free(placed);
+	free(worker_nodes);
+	RETURN_IF_ERROR(error);
+
+	// Initialize every deque before starting any thread, as the workers steal
+	// from each other.
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		worker_t* worker = executor->workers + i;
+		worker->executor = executor;
+		worker->steal_seed = 0x9e3779b97f4a7c15ull * (i + 1);
+		task_pool_init(&worker->pool);
+
+		RETURN_IF_ERROR(ws_deque_init(WORKER_DEQUE_CAPACITY, &worker->deque));
+		RETURN_IF_ERROR(
+			trace_buffer_init(options->trace_capacity, &worker->trace));
+		prv_worker_statistics_init(&worker->statistics);
+	}
+
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		worker_t* worker = executor->workers + i;
+		pthread_create(&worker->thread, NULL, &prv_worker_thread, worker);
 	}
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
@@ -99,14 +1079,26 @@ executor_destroy(executor_t* executor)
 {
 	ASSERT_PARAMETER(executor);
 
-	executor->halt = true;
-	pthread_cond_broadcast(&executor->queue.condition);
+	pthread_mutex_lock(&executor->park_lock);
+	atomic_store(&executor->halt, true);
+	pthread_cond_broadcast(&executor->park_condition);
+	pthread_mutex_unlock(&executor->park_lock);
 
-	for (uint64_t i = 0; i < NUM_THREADS; ++i) {
-		pthread_join(executor->workers[i], NULL);
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		pthread_join(executor->workers[i].thread, NULL);
 	}
 
-	ts_llist_queue_destroy(&executor->queue);
+	for (uint64_t i = 0; i < executor->num_workers; ++i) {
+		ws_deque_destroy(&executor->workers[i].deque);
+		task_pool_destroy(&executor->workers[i].pool);
+		trace_buffer_destroy(&executor->workers[i].trace);
+		free(executor->workers[i].cpus);
+	}
+
+	pthread_cond_destroy(&executor->park_condition);
+	pthread_mutex_destroy(&executor->park_lock);
 
+	free(executor->groups);
 	free(executor->workers);
-}
\ No newline at end of file
+	free(executor->cpu_nodes);
+}
@@ -0,0 +1,57 @@
+#include "graph.h"
+
+#include "utility/return_macro.h"
+
+// Reuse a released item, or take new memory from the arena.
+void*
+prv_graph_alloc(graph_t* graph, void** free_list, uint64_t size)
+{
+	void* item = *free_list;
+	if (item) {
+		*free_list = *(void**)item;
+		return item;
+	}
+
+	return arena_alloc(&graph->arena, size);
+}
+
+void
+prv_graph_release(void** free_list, void* item)
+{
+	*(void**)item = *free_list;
+	*free_list = item;
+}
+
+node_t*
+graph_alloc_node(graph_t* graph)
+{
+	ASSERT_PARAMETER(graph);
+
+	return prv_graph_alloc(graph, &graph->free_nodes, sizeof(node_t));
+}
+
+void
+graph_release_node(graph_t* graph, node_t* node)
+{
+	ASSERT_PARAMETER(graph);
+	ASSERT_PARAMETER(node);
+
+	prv_graph_release(&graph->free_nodes, node);
+}
+
+port_t*
+graph_alloc_port(graph_t* graph)
+{
+	ASSERT_PARAMETER(graph);
+
+	return prv_graph_alloc(graph, &graph->free_ports, sizeof(port_t));
+}
+
+void
+graph_release_port(graph_t* graph, port_t* port)
+{
+	ASSERT_PARAMETER(graph);
+	ASSERT_PARAMETER(port);
+
+	prv_graph_release(&graph->free_ports, port);
+}
@@ -26,4 +26,30 @@ fnv1a_64(const char* str)
 	}
 
 	return hash;
-}
\ No newline at end of file
+}
+
+uint64_t
+fnv1a_64_bytes(const void* bytes, uint64_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325;
+
+	const unsigned char* s = bytes;
+	for (uint64_t i = 0; i < len; ++i) {
+		hash ^= s[i];
+		hash *= 0x00000100000001b3;
+	}
+
+	return hash;
+}
+
+uint64_t
+hash_combine_64(uint64_t hash, uint64_t value)
+{
+	// The finalizer of splitmix64 spreads every bit of the value.
+	value += 0x9e3779b97f4a7c15;
+	value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+	value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+	value ^= value >> 31;
+
+	return (hash ^ value) * 0x00000100000001b3;
+}
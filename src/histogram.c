@@ -0,0 +1,173 @@
+#include "utility/histogram.h"
+
+#include "utility/return_macro.h"
+
+uint64_t
+prv_histogram_bucket_index(uint64_t value)
+{
+	if (value < HISTOGRAM_SUB_BUCKETS) {
+		return value;
+	}
+
+	// Position of the highest bit, at least HISTOGRAM_SUB_BUCKET_BITS.
+	uint64_t exponent = 63 - (uint64_t)__builtin_clzll(value);
+	uint64_t shift = exponent - HISTOGRAM_SUB_BUCKET_BITS;
+	uint64_t sub_bucket = (value >> shift) & (HISTOGRAM_SUB_BUCKETS - 1);
+
+	return (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub_bucket;
+}
+
+// Largest value counted in the bucket.
+uint64_t
+prv_histogram_bucket_upper(uint64_t index)
+{
+	if (index < HISTOGRAM_SUB_BUCKETS) {
+		return index;
+	}
+
+	uint64_t shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+	uint64_t sub_bucket = index % HISTOGRAM_SUB_BUCKETS;
+	uint64_t lower = (HISTOGRAM_SUB_BUCKETS + sub_bucket) << shift;
+
+	return lower + ((1ull << shift) - 1);
+}
+
+void
+histogram_init(histogram_t* histogram)
+{
+	ASSERT_PARAMETER(histogram);
+
+	atomic_init(&histogram->count, 0);
+	atomic_init(&histogram->sum, 0);
+	atomic_init(&histogram->max, 0);
+
+	for (uint64_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		atomic_init(&histogram->buckets[i], 0);
+	}
+}
+
+void
+histogram_record(histogram_t* histogram, uint64_t value)
+{
+	ASSERT_PARAMETER(histogram);
+
+	uint64_t index = prv_histogram_bucket_index(value);
+	atomic_fetch_add_explicit(&histogram->buckets[index], 1,
+		memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+	atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+
+	uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	while (value > max
+		&& !atomic_compare_exchange_weak_explicit(&histogram->max, &max, value,
+			memory_order_relaxed, memory_order_relaxed)) {
+	}
+}
+
+// Add to a counter only written by the calling thread.
+void
+prv_histogram_add(_Atomic(uint64_t)* counter, uint64_t amount)
+{
+	uint64_t value = atomic_load_explicit(counter, memory_order_relaxed);
+	atomic_store_explicit(counter, value + amount, memory_order_relaxed);
+}
+
+void
+histogram_record_exclusive(histogram_t* histogram, uint64_t value)
+{
+	ASSERT_PARAMETER(histogram);
+
+	uint64_t index = prv_histogram_bucket_index(value);
+	prv_histogram_add(&histogram->buckets[index], 1);
+	prv_histogram_add(&histogram->sum, value);
+	prv_histogram_add(&histogram->count, 1);
+
+	if (value > atomic_load_explicit(&histogram->max, memory_order_relaxed)) {
+		atomic_store_explicit(&histogram->max, value, memory_order_relaxed);
+	}
+}
+
+void
+histogram_snapshot_init(histogram_snapshot_t* snapshot)
+{
+	ASSERT_PARAMETER(snapshot);
+
+	snapshot->count = 0;
+	snapshot->sum = 0;
+	snapshot->max = 0;
+
+	for (uint64_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		snapshot->buckets[i] = 0;
+	}
+}
+
+void
+histogram_snapshot_add(histogram_snapshot_t* snapshot,
+	const histogram_t* histogram)
+{
+	ASSERT_PARAMETER(snapshot);
+	ASSERT_PARAMETER(histogram);
+
+	// Count the buckets instead of reading the count, so the quantiles stay
+	// consistent with it while values are being recorded.
+	for (uint64_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		uint64_t count = atomic_load_explicit(&histogram->buckets[i],
+			memory_order_relaxed);
+
+		snapshot->buckets[i] += count;
+		snapshot->count += count;
+	}
+
+	snapshot->sum
+		+= atomic_load_explicit(&histogram->sum, memory_order_relaxed);
+
+	uint64_t max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	if (max > snapshot->max) {
+		snapshot->max = max;
+	}
+}
+
+uint64_t
+histogram_snapshot_quantile(const histogram_snapshot_t* snapshot, double q)
+{
+	ASSERT_PARAMETER(snapshot);
+
+	if (snapshot->count == 0) {
+		return 0;
+	}
+
+	// Rank of the value, counting from 1.
+	uint64_t rank = (uint64_t)(q * (double)snapshot->count);
+	if (rank < 1) {
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for (uint64_t i = 0; i < HISTOGRAM_NUM_BUCKETS; ++i) {
+		seen += snapshot->buckets[i];
+
+		if (seen >= rank) {
+			uint64_t upper = prv_histogram_bucket_upper(i);
+			return upper < snapshot->max ? upper : snapshot->max;
+		}
+	}
+
+	return snapshot->max;
+}
+
+void
+histogram_snapshot_summarize(const histogram_snapshot_t* snapshot,
+	daggle_duration_summary_t* out_summary)
+{
+	ASSERT_PARAMETER(snapshot);
+	ASSERT_OUTPUT_PARAMETER(out_summary);
+
+	out_summary->count = snapshot->count;
+	out_summary->mean_ns
+		= snapshot->count > 0 ? snapshot->sum / snapshot->count : 0;
+	out_summary->p50_ns = histogram_snapshot_quantile(snapshot, 0.5);
+	out_summary->p90_ns = histogram_snapshot_quantile(snapshot, 0.9);
+	out_summary->p99_ns = histogram_snapshot_quantile(snapshot, 0.99);
+	out_summary->p999_ns = histogram_snapshot_quantile(snapshot, 0.999);
+	out_summary->max_ns = snapshot->max;
+}
@@ -0,0 +1,386 @@
+#include "memo_cache.h"
+
+#include "node.h"
+#include "ports.h"
+#include "stdlib.h"
+#include "utility/hash.h"
+#include "utility/return_macro.h"
+
+// Hash of a port without a value.
+#define MEMO_EMPTY_VALUE_HASH 0x6e6f6e65ull
+
+daggle_error_code_t
+memo_cache_init(daggle_instance_h instance,
+	const daggle_instance_options_t* options, memo_cache_t* cache)
+{
+	ASSERT_PARAMETER(instance);
+	ASSERT_PARAMETER(options);
+	ASSERT_PARAMETER(cache);
+
+	uint64_t capacity = options->memo_capacity;
+
+	cache->instance = instance;
+	cache->buckets = NULL;
+	cache->num_buckets = 0;
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	cache->num_entries = 0;
+	cache->capacity = capacity;
+
+	atomic_init(&cache->hits, 0);
+	atomic_init(&cache->misses, 0);
+	atomic_init(&cache->evictions, 0);
+
+	if (capacity > 0) {
+		uint64_t num_buckets = 1;
+		while (num_buckets < capacity) {
+			num_buckets <<= 1;
+		}
+
+		cache->buckets = calloc(num_buckets, sizeof(memo_entry_t*));
+		REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(cache->buckets);
+
+		cache->num_buckets = num_buckets;
+	}
+
+	pthread_mutex_init(&cache->lock, NULL);
+
+	daggle_error_code_t error = disk_cache_init(options->memo_directory,
+		options->memo_directory_max_bytes, options->memo_directory_eviction,
+		&cache->disk);
+	if (error != DAGGLE_SUCCESS) {
+		// The disk cache is left safe to destroy when its init fails.
+		disk_cache_destroy(&cache->disk);
+		pthread_mutex_destroy(&cache->lock);
+		free(cache->buckets);
+		cache->buckets = NULL;
+	}
+
+	RETURN_STATUS(error);
+}
+
+void
+prv_memo_entry_free(memo_cache_t* cache, memo_entry_t* entry)
+{
+	for (uint64_t i = 0; i < entry->num_outputs; ++i) {
+		memo_output_t* output = entry->outputs + i;
+
+		output->info->freer(cache->instance, output->data);
+	}
+
+	free(entry->outputs);
+	free(entry);
+}
+
+void
+memo_cache_destroy(memo_cache_t* cache)
+{
+	ASSERT_PARAMETER(cache);
+
+	memo_entry_t* entry = cache->newest;
+	while (entry) {
+		memo_entry_t* older = entry->older;
+		prv_memo_entry_free(cache, entry);
+		entry = older;
+	}
+
+	free(cache->buckets);
+	cache->buckets = NULL;
+	cache->num_buckets = 0;
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	cache->num_entries = 0;
+
+	pthread_mutex_destroy(&cache->lock);
+
+	disk_cache_destroy(&cache->disk);
+}
+
+bool
+memo_cache_is_enabled(const memo_cache_t* cache)
+{
+	ASSERT_PARAMETER(cache);
+
+	return cache->capacity > 0 || disk_cache_is_enabled(&cache->disk);
+}
+
+uint64_t
+memo_cache_compute_key(struct node_s* node, execution_context_t* context)
+{
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(context);
+
+	// Ports are summed up, as the order they are stored in depends on the
+	// history of the node.
+	uint64_t ports_hash = 0;
+
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t* port = node_get_port_by_index(node, i);
+		if (port->port_variant == DAGGLE_PORT_OUTPUT) {
+			continue;
+		}
+
+		data_container_t* container = port_get_container(port, context);
+
+		uint64_t value_hash = MEMO_EMPTY_VALUE_HASH;
+		if (container && data_container_has_value(container)) {
+			value_hash = type_info_hash_data(container->info,
+				container->instance, container->data);
+		}
+
+		uint64_t port_hash = fnv1a_64(port->name_hash.name);
+		port_hash = hash_combine_64(port_hash, port->port_variant);
+		port_hash = hash_combine_64(port_hash, value_hash);
+
+		ports_hash += port_hash;
+	}
+
+	return hash_combine_64(fnv1a_64(node->info->name_hash.name), ports_hash);
+}
+
+memo_entry_t**
+prv_memo_cache_bucket(memo_cache_t* cache, uint64_t key)
+{
+	return cache->buckets + (key & (cache->num_buckets - 1));
+}
+
+// Entry with the key for the node type, or NULL. Must hold the lock.
+memo_entry_t*
+prv_memo_cache_find(memo_cache_t* cache, uint64_t key, node_info_t* info)
+{
+	memo_entry_t* entry = *prv_memo_cache_bucket(cache, key);
+
+	while (entry && (entry->key != key || entry->node_info != info)) {
+		entry = entry->chain;
+	}
+
+	return entry;
+}
+
+void
+prv_memo_cache_unlink_recency(memo_cache_t* cache, memo_entry_t* entry)
+{
+	if (entry->newer) {
+		entry->newer->older = entry->older;
+	} else {
+		cache->newest = entry->older;
+	}
+
+	if (entry->older) {
+		entry->older->newer = entry->newer;
+	} else {
+		cache->oldest = entry->newer;
+	}
+
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+void
+prv_memo_cache_push_newest(memo_cache_t* cache, memo_entry_t* entry)
+{
+	entry->newer = NULL;
+	entry->older = cache->newest;
+
+	if (cache->newest) {
+		cache->newest->newer = entry;
+	} else {
+		cache->oldest = entry;
+	}
+
+	cache->newest = entry;
+}
+
+// Drop the least recently used entry. Must hold the lock.
+void
+prv_memo_cache_evict(memo_cache_t* cache)
+{
+	memo_entry_t* entry = cache->oldest;
+	prv_memo_cache_unlink_recency(cache, entry);
+
+	memo_entry_t** link = prv_memo_cache_bucket(cache, entry->key);
+	while (*link != entry) {
+		link = &(*link)->chain;
+	}
+
+	*link = entry->chain;
+	--cache->num_entries;
+
+	prv_memo_entry_free(cache, entry);
+
+	atomic_fetch_add_explicit(&cache->evictions, 1, memory_order_relaxed);
+}
+
+// Copy the outputs of an entry to the node in the context. Must hold the
+// lock, the entry may be evicted right after.
+void
+prv_memo_cache_copy_outputs(memo_entry_t* entry, node_t* node,
+	execution_context_t* context)
+{
+	for (uint64_t i = 0; i < entry->num_outputs; ++i) {
+		memo_output_t* output = entry->outputs + i;
+
+		port_t* port = node_get_port_by_atom(node, output->name_hash.name);
+		if (!port || port->port_variant != DAGGLE_PORT_OUTPUT) {
+			continue;
+		}
+
+		context_port_t* state = execution_context_get_port(context, port);
+		if (!state) {
+			continue;
+		}
+
+		data_container_replace_copy(&state->value, output->info,
+			output->data);
+	}
+}
+
+// Look the key up in memory.
+bool
+prv_memo_cache_load_memory(memo_cache_t* cache, uint64_t key, node_t* node,
+	execution_context_t* context)
+{
+	if (cache->capacity == 0) {
+		return false;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	memo_entry_t* entry = prv_memo_cache_find(cache, key, node->info);
+	if (entry) {
+		prv_memo_cache_unlink_recency(cache, entry);
+		prv_memo_cache_push_newest(cache, entry);
+
+		prv_memo_cache_copy_outputs(entry, node, context);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	return entry != NULL;
+}
+
+// Copy the outputs of a node with a value into a new entry.
+memo_entry_t*
+prv_memo_entry_create(memo_cache_t* cache, uint64_t key, node_t* node,
+	execution_context_t* context)
+{
+	memo_entry_t* entry = malloc(sizeof *entry);
+	if (!entry) {
+		return NULL;
+	}
+
+	entry->key = key;
+	entry->node_info = node->info;
+	entry->num_outputs = 0;
+	entry->chain = NULL;
+	entry->newer = NULL;
+	entry->older = NULL;
+
+	entry->outputs = malloc(sizeof(memo_output_t) * (node->ports.length + 1));
+	if (!entry->outputs) {
+		free(entry);
+		return NULL;
+	}
+
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t* port = node_get_port_by_index(node, i);
+		if (port->port_variant != DAGGLE_PORT_OUTPUT) {
+			continue;
+		}
+
+		data_container_t* container = port_get_container(port, context);
+		if (!container || !data_container_has_value(container)) {
+			continue;
+		}
+
+		// The name is interned, it outlives the cache.
+		memo_output_t* output = entry->outputs + entry->num_outputs++;
+		output->name_hash = port->name_hash;
+		output->info = container->info;
+		output->data = NULL;
+
+		container->info->cloner(cache->instance, container->data,
+			&output->data);
+	}
+
+	return entry;
+}
+
+// Keep copies of the outputs in memory.
+void
+prv_memo_cache_store_memory(memo_cache_t* cache, uint64_t key, node_t* node,
+	execution_context_t* context)
+{
+	if (cache->capacity == 0) {
+		return;
+	}
+
+	// Copy before taking the lock, other nodes may be looking up meanwhile.
+	memo_entry_t* entry = prv_memo_entry_create(cache, key, node, context);
+	if (!entry) {
+		return;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+
+	// Another run of an equal node got here first.
+	if (prv_memo_cache_find(cache, key, node->info)) {
+		pthread_mutex_unlock(&cache->lock);
+
+		prv_memo_entry_free(cache, entry);
+		return;
+	}
+
+	memo_entry_t** bucket = prv_memo_cache_bucket(cache, key);
+	entry->chain = *bucket;
+	*bucket = entry;
+
+	prv_memo_cache_push_newest(cache, entry);
+	++cache->num_entries;
+
+	while (cache->num_entries > cache->capacity) {
+		prv_memo_cache_evict(cache);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+}
+
+bool
+memo_cache_load(memo_cache_t* cache, uint64_t key, struct node_s* node,
+	execution_context_t* context)
+{
+	ASSERT_PARAMETER(cache);
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(context);
+
+	if (prv_memo_cache_load_memory(cache, key, node, context)) {
+		atomic_fetch_add_explicit(&cache->hits, 1, memory_order_relaxed);
+		return true;
+	}
+
+	if (disk_cache_is_enabled(&cache->disk)
+		&& disk_cache_load(&cache->disk, cache->instance, key, node,
+			context)) {
+		// Later lookups don't have to go to the directory.
+		prv_memo_cache_store_memory(cache, key, node, context);
+		return true;
+	}
+
+	atomic_fetch_add_explicit(&cache->misses, 1, memory_order_relaxed);
+	return false;
+}
+
+void
+memo_cache_store(memo_cache_t* cache, uint64_t key, struct node_s* node,
+	execution_context_t* context)
+{
+	ASSERT_PARAMETER(cache);
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(context);
+
+	prv_memo_cache_store_memory(cache, key, node, context);
+
+	if (disk_cache_is_enabled(&cache->disk)) {
+		disk_cache_store(&cache->disk, cache->instance, key, node, context);
+	}
+}
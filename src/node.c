@@ -26,21 +26,21 @@ node_create(daggle_graph_h graph, const char* node_type, node_t** out_node)
 		&graph_impl->instance->plugin_manager.res, node_type, &info));
 
 	// Allocate a new node instance
-	node_t* node = malloc(sizeof *node);
+	node_t* node = graph_alloc_node(graph_impl);
 	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(node);
 
-	// Create a port array.
-	daggle_error_code_t error
-		= dynamic_array_init(0, sizeof(port_t), &node->ports);
-	if (error != DAGGLE_SUCCESS) {
-		free(node);
-		RETURN_STATUS(error);
-	}
+	// Create the port arrays.
+	dynamic_array_init(0, sizeof(port_t*), &node->ports);
+	dynamic_array_init(0, sizeof(port_t*), &node->ports_by_id);
 
 	node->instance_task = NULL;
 	node->info = info;
 
 	node->graph = graph_impl;
+	node->slot = graph_impl->num_node_slots++;
+	node->version = 1;
+	node->is_volatile = false;
+	node->is_memoized = false;
 
 	node->custom_context = NULL;
 	node->custom_context_destructor = NULL;
@@ -60,20 +60,38 @@ node_free(node_t* node)
 		node->custom_context_destructor(node->custom_context);
 	}
 
+	graph_t* graph = node->graph;
+
+	// Links of the other nodes to the ports are removed with them.
 	for (uint64_t i = 0; i < node->ports.length; ++i) {
-		port_t* port = dynamic_array_at(&node->ports, i);
+		port_t** portelem = dynamic_array_at(&node->ports, i);
+		port_destroy(*portelem);
+		graph_release_port(graph, *portelem);
+	}
 
-		// Only inputs and outputs have edges. Skip the parameter.
-		if (port->port_variant != DAGGLE_PORT_PARAMETER) {
-			continue;
-		}
+	dynamic_array_destroy(&node->ports);
+	dynamic_array_destroy(&node->ports_by_id);
 
-		port_destroy(port);
+	graph_release_node(graph, node);
+}
+
+void
+node_destroy(node_t* node)
+{
+	ASSERT_PARAMETER(node);
+
+	if (node->custom_context_destructor) {
+		node->custom_context_destructor(node->custom_context);
 	}
 
-	dynamic_array_destroy(&node->ports);
+	// The memory of the ports goes with the arena.
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t** portelem = dynamic_array_at(&node->ports, i);
+		port_release(*portelem);
+	}
 
-	free(node);
+	dynamic_array_destroy(&node->ports);
+	dynamic_array_destroy(&node->ports_by_id);
 }
 
 port_t*
@@ -82,13 +100,28 @@ node_get_port_by_name(node_t* node, const char* port_name)
 	ASSERT_PARAMETER(node);
 	ASSERT_PARAMETER(port_name);
 
-	uint32_t search_hash = fnv1a_32(port_name);
+	graph_t* graph = node->graph;
+
+	// A name which was never interned can't be the name of a port.
+	name_with_hash_t atom;
+	if (!atom_table_find(&graph->instance->atoms, port_name, &atom)) {
+		return NULL;
+	}
+
+	return node_get_port_by_atom(node, atom.name);
+}
+
+port_t*
+node_get_port_by_atom(node_t* node, const char* atom)
+{
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(atom);
 
 	for (uint64_t i = 0; i < node->ports.length; ++i) {
-		port_t* item = dynamic_array_at(&node->ports, i);
+		port_t** itemelem = dynamic_array_at(&node->ports, i);
+		port_t* item = *itemelem;
 
-		if (item->name_hash.hash == search_hash
-			&& !strcmp(port_name, item->name_hash.name)) {
+		if (item->name_hash.name == atom) {
 			return item;
 		}
 	}
@@ -103,7 +136,41 @@ node_get_port_by_index(node_t* node, uint64_t index)
 
 	ASSERT_TRUE(index < node->ports.length, "Port index out of bounds");
 
-	return dynamic_array_at(&node->ports, index);
+	port_t** portelem = dynamic_array_at(&node->ports, index);
+	return *portelem;
+}
+
+port_t*
+node_get_port_by_id(node_t* node, daggle_port_id_t id)
+{
+	ASSERT_PARAMETER(node);
+
+	if (id >= node->ports_by_id.length) {
+		return NULL;
+	}
+
+	port_t** portelem = dynamic_array_at(&node->ports_by_id, id);
+	return *portelem;
+}
+
+daggle_error_code_t
+node_add_port(node_t* node, port_t* port)
+{
+	ASSERT_PARAMETER(node);
+	ASSERT_PARAMETER(port);
+
+	port->id = node->ports_by_id.length;
+
+	RETURN_IF_ERROR(dynamic_array_push(&node->ports_by_id, &port));
+
+	daggle_error_code_t error = dynamic_array_push(&node->ports, &port);
+	if (error != DAGGLE_SUCCESS) {
+		// Keep the id taken, ids are not reused.
+		port_t** portelem = dynamic_array_at(&node->ports_by_id, port->id);
+		*portelem = NULL;
+	}
+
+	RETURN_STATUS(error);
 }
 
 void
@@ -117,11 +184,13 @@ node_compute_declarations(node_t* node)
 
 	node->custom_context = NULL;
 	node->custom_context_destructor = NULL;
+	node->is_volatile = false;
+	node->is_memoized = false;
 
 	// Reset declaration state flags to undeclared.
 	for (uint64_t i = 0; i < node->ports.length; ++i) {
-		port_t* port = dynamic_array_at(&node->ports, i);
-		port->declared = false;
+		port_t** portelem = dynamic_array_at(&node->ports, i);
+		(*portelem)->declared = false;
 	}
 
 	// Get the node declarator function.
@@ -130,16 +199,30 @@ node_compute_declarations(node_t* node)
 	// Declaration functions should set the flag on.
 	declare_fn(node);
 
-	// Remove undeclared ports.
-	for (uint64_t i = 0; i < node->ports.length; ++i) {
-		port_t* port = dynamic_array_at(&node->ports, i);
+	// Remove undeclared ports. The following ports move down, so the index
+	// only advances past kept ones.
+	uint64_t i = 0;
+	while (i < node->ports.length) {
+		port_t** portelem = dynamic_array_at(&node->ports, i);
+		port_t* port = *portelem;
 
-		if (!port->declared) {
-			port_destroy(port);
-			dynamic_array_remove(&node->ports, i);
+		if (port->declared) {
+			++i;
+			continue;
 		}
+
+		port_t** idelem = dynamic_array_at(&node->ports_by_id, port->id);
+		*idelem = NULL;
+
+		dynamic_array_remove(&node->ports, i);
+		port_destroy(port);
+		graph_release_port(node->graph, port);
 	}
 
+	// Plans only depend on the links, removing a linked port above already
+	// bumped the revision of the graph when unlinking it.
+	++node->version;
+
 	// If custom context was not set, implicitly use node as the context.
 	if (!node->custom_context_destructor && !node->custom_context) {
 		daggle_node_declare_context(node, node, NULL);
@@ -0,0 +1,619 @@
+#include "plan.h"
+
+#include "graph.h"
+#include "memo_cache.h"
+#include "node.h"
+#include "ports.h"
+#include "stdalign.h"
+#include "stdlib.h"
+#include "utility/clock.h"
+#include "utility/log_macro.h"
+#include "utility/return_macro.h"
+
+// Weight of node types which haven't been run yet.
+#define DEFAULT_NODE_DURATION_NS 1000
+
+void
+prv_graph_master_task_function(void* context)
+{
+	ASSERT_NOT_NULL(context, "context is null");
+	LOG(LOG_TAG_INFO, "Run Graph");
+}
+
+void
+prv_graph_master_task_dispose(void* context)
+{
+	ASSERT_NOT_NULL(context, "context is null");
+	plan_t* plan = context;
+
+	LOG(LOG_TAG_INFO, "Finish Graph");
+
+	execution_context_t* execution_context = plan->context;
+
+	graph_t* graph = plan->graph;
+	histogram_record(&graph->execution_latency,
+		clock_now_ns() - plan->started_ns);
+
+	// The plan may be run or freed again once either is released, the plan
+	// goes first so that the next run can't be marked finished here.
+	if (plan->is_transient) {
+		plan_destroy(plan);
+		free(plan);
+	} else {
+		atomic_store(&plan->executing, false);
+	}
+
+	execution_context_end(execution_context);
+}
+
+// Count the acquiring inputs of a node as spent, when its outputs are loaded
+// from the cache instead of running the task, so the outputs they are linked
+// to can still be taken by the other inputs, or released.
+void
+prv_node_spend_acquired_inputs(node_t* node, execution_context_t* context)
+{
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t* port = node_get_port_by_index(node, i);
+		if (port->port_variant != DAGGLE_PORT_INPUT
+			|| port->variant.input.behavior != DAGGLE_INPUT_BEHAVIOR_ACQUIRE
+			|| !port->variant.input.link) {
+			continue;
+		}
+
+		context_port_t* state = execution_context_get_port(context, port);
+		if (!state || state->has_spent_access) {
+			continue;
+		}
+
+		state->has_spent_access = true;
+		execution_context_finish_access(context, port->variant.input.link);
+	}
+}
+
+void
+prv_node_call_function(daggle_task_h task, void* context)
+{
+	node_t* node = context;
+	task_t* task_impl = task;
+	execution_context_t* execution_context = task_impl->execution_context;
+
+	graph_t* graph = node->graph;
+	memo_cache_t* cache = &graph->instance->memo_cache;
+
+	// The key is computed before the task may take the input values.
+	bool is_memoized = node->is_memoized && memo_cache_is_enabled(cache);
+	uint64_t key = 0;
+	if (is_memoized) {
+		key = memo_cache_compute_key(node, execution_context);
+	}
+
+	if (is_memoized && memo_cache_load(cache, key, node, execution_context)) {
+		prv_node_spend_acquired_inputs(node, execution_context);
+	} else {
+		uint64_t start = clock_now_ns();
+		node->instance_task(task, node->custom_context);
+		node_info_record_duration(node->info, clock_now_ns() - start);
+
+		if (is_memoized) {
+			memo_cache_store(cache, key, node, execution_context);
+		}
+	}
+
+	// The outputs in the context are now those of the current version.
+	context_node_t* state = execution_context_get_node(execution_context, node);
+	if (state) {
+		state->version = node->version;
+		state->is_dirty = false;
+	}
+}
+
+void
+prv_node_call_dispose(void* context)
+{
+	node_t* node = context;
+
+	// Subtract reference accesses, the node is done with the values.
+	for (uint64_t i = 0; i < node->ports.length; ++i) {
+		port_t* port = node_get_port_by_index(node, i);
+		if (port->port_variant != DAGGLE_PORT_INPUT
+			|| port->variant.input.behavior != DAGGLE_INPUT_BEHAVIOR_REFERENCE
+			|| !port->variant.input.link) {
+			continue;
+		}
+
+		port_t* link = port->variant.input.link;
+		execution_context_finish_access(execution_context_resolve(link), link);
+	}
+
+	// The custom context belongs to the node, not to the execution. It is
+	// destroyed when the node is redeclared or freed.
+}
+
+int
+prv_task_compare_priority(const void* a, const void* b)
+{
+	const task_t* task_a = *(task_t* const*)a;
+	const task_t* task_b = *(task_t* const*)b;
+
+	// Descending.
+	return (task_a->priority < task_b->priority)
+		- (task_a->priority > task_b->priority);
+}
+
+void
+plan_init(struct graph_s* graph, execution_context_t* context, plan_t* plan)
+{
+	ASSERT_PARAMETER(graph);
+	ASSERT_PARAMETER(context);
+	ASSERT_PARAMETER(plan);
+
+	plan->graph = graph;
+	plan->context = context;
+	plan->revision = 0;
+
+	plan->tasks = NULL;
+	plan->num_tasks = 0;
+	plan->dependant_offsets = NULL;
+	plan->dependants = NULL;
+	plan->num_dependencies = NULL;
+	plan->order = NULL;
+	plan->roots = NULL;
+	plan->num_roots = 0;
+	plan->num_leaves = 0;
+	plan->num_scheduled = 0;
+
+	plan->is_transient = false;
+	atomic_init(&plan->executing, false);
+	plan->started_ns = 0;
+}
+
+// Free the tasks and the arrays describing them.
+void
+prv_plan_release_tasks(plan_t* plan)
+{
+	for (uint64_t i = 0; i < plan->num_tasks; ++i) {
+		task_t* task = plan->tasks + i;
+
+		// Node tasks may have added subtasks to themselves in the last run.
+		if (task_owns_dependants(task)) {
+			free(task->dependants);
+		}
+	}
+
+	free(plan->tasks);
+	free(plan->dependant_offsets);
+	free(plan->dependants);
+	free(plan->num_dependencies);
+	free(plan->order);
+	free(plan->roots);
+
+	plan->tasks = NULL;
+	plan->num_tasks = 0;
+	plan->dependant_offsets = NULL;
+	plan->dependants = NULL;
+	plan->num_dependencies = NULL;
+	plan->order = NULL;
+	plan->roots = NULL;
+	plan->num_roots = 0;
+	plan->num_leaves = 0;
+	plan->num_scheduled = 0;
+}
+
+void
+plan_destroy(plan_t* plan)
+{
+	ASSERT_PARAMETER(plan);
+
+	prv_plan_release_tasks(plan);
+}
+
+// Whether a node linked to is a node of the graph, which it always should be.
+bool
+prv_plan_has_node(graph_t* graph, node_t* node)
+{
+	if (node->graph != graph || node->index >= graph->nodes.length) {
+		return false;
+	}
+
+	node_t** nodeelem = dynamic_array_at(&graph->nodes, node->index);
+	return *nodeelem == node;
+}
+
+// Set the priority of every task to its bottom level, the longest path from
+// the start of the task to the end of the graph, weighted by the measured
+// durations of the node types. Sort the dependants by it, and store the
+// topological order it is computed in.
+daggle_error_code_t
+prv_plan_prioritize(plan_t* plan)
+{
+	task_t** order = plan->order;
+
+	// Topological order, using the priority as the remaining in-degree.
+	uint64_t num_ordered = 0;
+	for (uint64_t i = 0; i < plan->num_tasks; ++i) {
+		task_t* tk = plan->tasks + i;
+
+		tk->priority = plan->num_dependencies[i];
+		if (tk->priority == 0) {
+			order[num_ordered++] = tk;
+		}
+	}
+
+	for (uint64_t i = 0; i < num_ordered; ++i) {
+		task_t* tk = order[i];
+
+		for (uint64_t j = 0; j < tk->num_dependants; ++j) {
+			task_t* dependant = tk->dependants[j];
+
+			if (--dependant->priority == 0) {
+				order[num_ordered++] = dependant;
+			}
+		}
+	}
+
+	// Dependants come after their dependencies, so walking backwards every
+	// dependant is done before the tasks depending on it.
+	for (uint64_t i = num_ordered; i-- > 0;) {
+		task_t* tk = order[i];
+		node_t* node = tk->node_context;
+
+		uint64_t duration
+			= atomic_load_explicit(&node->info->average_duration_ns,
+				memory_order_relaxed);
+
+		uint64_t longest = 0;
+		for (uint64_t j = 0; j < tk->num_dependants; ++j) {
+			if (tk->dependants[j]->priority > longest) {
+				longest = tk->dependants[j]->priority;
+			}
+		}
+
+		tk->priority
+			= (duration ? duration : DEFAULT_NODE_DURATION_NS) + longest;
+
+		qsort(tk->dependants, tk->num_dependants, sizeof(task_t*),
+			prv_task_compare_priority);
+	}
+
+	// A cycle leaves tasks unordered, those would never run anyway.
+	if (num_ordered != plan->num_tasks) {
+		LOG(LOG_TAG_ERROR, "The graph contains a cycle");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// Create a task for every node and store the dependants of each, found
+// through the links of its outputs, in one array.
+daggle_error_code_t
+prv_plan_build(plan_t* plan)
+{
+	graph_t* graph = plan->graph;
+	dynamic_array_t* nodes = &graph->nodes;
+	uint64_t num_nodes = nodes->length;
+
+	if (num_nodes == 0) {
+		LOG(LOG_TAG_ERROR,
+			"At least one node must be defined to execute a graph");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	prv_plan_release_tasks(plan);
+
+	plan->tasks = aligned_alloc(alignof(task_t), sizeof(task_t) * num_nodes);
+	plan->dependant_offsets = calloc(num_nodes + 1, sizeof(uint64_t));
+	plan->num_dependencies = calloc(num_nodes, sizeof(uint64_t));
+	plan->order = malloc(sizeof(task_t*) * num_nodes);
+	plan->roots = malloc(sizeof(task_t*) * num_nodes);
+
+	if (!plan->tasks || !plan->dependant_offsets || !plan->num_dependencies
+		|| !plan->order || !plan->roots) {
+		prv_plan_release_tasks(plan);
+		RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+	}
+
+	uint64_t* offsets = plan->dependant_offsets;
+
+	// Count the dependants and dependencies of every node.
+	for (uint64_t i = 0; i < num_nodes; ++i) {
+		node_t** nodeelem = dynamic_array_at(nodes, i);
+		node_t* node = *nodeelem;
+
+		for (uint64_t j = 0; j < node->ports.length; ++j) {
+			port_t* item = node_get_port_by_index(node, j);
+			if (item->port_variant != DAGGLE_PORT_OUTPUT) {
+				continue;
+			}
+
+			dynamic_array_t* links = &item->variant.output.links;
+			for (uint64_t k = 0; k < links->length; ++k) {
+				port_t** linkelem = dynamic_array_at(links, k);
+				node_t* owner = (*linkelem)->owner;
+
+				if (!prv_plan_has_node(graph, owner)) {
+					continue;
+				}
+
+				++offsets[i + 1];
+				++plan->num_dependencies[owner->index];
+			}
+		}
+	}
+
+	for (uint64_t i = 0; i < num_nodes; ++i) {
+		offsets[i + 1] += offsets[i];
+	}
+
+	// At least one element, so a graph without links isn't mistaken for an
+	// allocation failure.
+	uint64_t num_links = offsets[num_nodes];
+	plan->dependants
+		= malloc(sizeof(task_t*) * (num_links > 0 ? num_links : 1));
+	if (!plan->dependants) {
+		prv_plan_release_tasks(plan);
+		RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+	}
+
+	plan->num_tasks = num_nodes;
+
+	// Create the tasks and fill in the dependants.
+	for (uint64_t i = 0; i < num_nodes; ++i) {
+		node_t** nodeelem = dynamic_array_at(nodes, i);
+		node_t* node = *nodeelem;
+
+		task_t* task = plan->tasks + i;
+		task_init(task);
+		task->pool = NULL;
+		task_set_node_task(task, prv_node_call_function, prv_node_call_dispose,
+			node);
+		task->id = node->info->name_hash.name;
+
+		uint64_t num_dependants = 0;
+		task_t** dependants = plan->dependants + offsets[i];
+
+		for (uint64_t j = 0; j < node->ports.length; ++j) {
+			port_t* item = node_get_port_by_index(node, j);
+			if (item->port_variant != DAGGLE_PORT_OUTPUT) {
+				continue;
+			}
+
+			dynamic_array_t* links = &item->variant.output.links;
+			for (uint64_t k = 0; k < links->length; ++k) {
+				port_t** linkelem = dynamic_array_at(links, k);
+				node_t* owner = (*linkelem)->owner;
+
+				// Skipped when counting too.
+				if (!prv_plan_has_node(graph, owner)) {
+					continue;
+				}
+
+				dependants[num_dependants++] = plan->tasks + owner->index;
+			}
+		}
+
+		// Borrow the dependants from the plan.
+		task->dependants = dependants;
+		task->num_dependants = num_dependants;
+		task->dependants_capacity = 0;
+	}
+
+	daggle_error_code_t error = prv_plan_prioritize(plan);
+	if (error != DAGGLE_SUCCESS) {
+		prv_plan_release_tasks(plan);
+		RETURN_STATUS(error);
+	}
+
+	plan->revision = graph->revision;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+plan_compile(plan_t* plan)
+{
+	ASSERT_PARAMETER(plan);
+
+	// The tasks are only used by runs in the context, claiming it makes sure
+	// none is in flight.
+	RETURN_IF_ERROR(execution_context_begin(plan->context));
+
+	daggle_error_code_t error = prv_plan_build(plan);
+
+	execution_context_end(plan->context);
+
+	RETURN_STATUS(error);
+}
+
+// Schedule the tasks of the next run as subtasks of its master task, and bring
+// them back to the state they were built in. Every task is scheduled unless
+// executing incrementally, then only the dirty nodes and the nodes depending
+// on them. Dependants of a scheduled task are scheduled as well, so a
+// scheduled task only has to wait for its scheduled dependencies, which are
+// counted in its pending dependencies as they are scheduled.
+void
+prv_plan_schedule(plan_t* plan, task_t* master, task_t* sink)
+{
+	execution_context_t* context = plan->context;
+	graph_t* graph = plan->graph;
+	bool is_incremental = graph->instance->incremental_execution;
+
+	for (uint64_t i = 0; i < plan->num_tasks; ++i) {
+		atomic_store_explicit(&plan->tasks[i].num_pending_dependencies, 0,
+			memory_order_relaxed);
+	}
+
+	plan->num_roots = 0;
+	plan->num_leaves = 0;
+	plan->num_scheduled = 0;
+
+	// Dependencies come first, so the count of a task is final once reached.
+	for (uint64_t i = 0; i < plan->num_tasks; ++i) {
+		task_t* task = plan->order[i];
+		uint64_t index = task - plan->tasks;
+
+		uint64_t num_dependencies = atomic_load_explicit(
+			&task->num_pending_dependencies, memory_order_relaxed);
+
+		bool is_scheduled = !is_incremental || num_dependencies > 0
+			|| execution_context_is_node_dirty(context, task->node_context);
+		if (!is_scheduled) {
+			continue;
+		}
+
+		// Stays dirty until the node has run, in case the run is cancelled.
+		context_node_t* state
+			= execution_context_get_node(context, task->node_context);
+		if (state) {
+			state->is_dirty = true;
+		}
+
+		// Node tasks may have added subtasks to themselves in the last run.
+		if (task_owns_dependants(task)) {
+			free(task->dependants);
+		}
+
+		uint64_t first = plan->dependant_offsets[index];
+		uint64_t num_dependants = plan->dependant_offsets[index + 1] - first;
+
+		if (num_dependants > 0) {
+			task->dependants = plan->dependants + first;
+			task->num_dependants = num_dependants;
+			task->dependants_capacity = 0;
+
+			for (uint64_t j = 0; j < num_dependants; ++j) {
+				atomic_fetch_add_explicit(
+					&task->dependants[j]->num_pending_dependencies, 1,
+					memory_order_relaxed);
+			}
+		} else {
+			// Leaves finish the subgraph of the master.
+			task->dependants = task->inline_dependants;
+			task->inline_dependants[0] = sink;
+			task->num_dependants = 1;
+			task->dependants_capacity = TASK_INLINE_DEPENDANTS;
+
+			++plan->num_leaves;
+		}
+
+		task->head = master;
+		task->tail = NULL;
+		task->num_subtasks = 0;
+		task->execution = NULL;
+		task->execution_context = NULL;
+
+		atomic_store_explicit(&task->num_pending_subtasks, 1,
+			memory_order_relaxed);
+
+		// Roots wait for the master.
+		if (num_dependencies == 0) {
+			atomic_store_explicit(&task->num_pending_dependencies, 1,
+				memory_order_relaxed);
+			plan->roots[plan->num_roots++] = task;
+		}
+
+		++plan->num_scheduled;
+	}
+
+	// Start with the roots of the longest paths.
+	qsort(plan->roots, plan->num_roots, sizeof(task_t*),
+		prv_task_compare_priority);
+}
+
+daggle_error_code_t
+plan_instantiate(plan_t* plan, task_t** out_task)
+{
+	ASSERT_PARAMETER(plan);
+	ASSERT_OUTPUT_PARAMETER(out_task);
+
+	// Claims the context, and with it the tasks, until the master task is
+	// disposed.
+	RETURN_IF_ERROR(execution_context_begin(plan->context));
+
+	plan->started_ns = clock_now_ns();
+
+	daggle_error_code_t error = DAGGLE_SUCCESS;
+	graph_t* graph = plan->graph;
+
+	if (!plan->tasks || plan->revision != graph->revision) {
+		error = prv_plan_build(plan);
+		GOTO_IF_ERROR(error, context_error);
+	}
+
+	task_t* master_task = task_alloc();
+	if (!master_task) {
+		error = DAGGLE_ERROR_MEMORY_ALLOCATION;
+		goto context_error;
+	}
+
+	task_t* sink = task_create_sink(master_task);
+	if (!sink) {
+		task_free(master_task);
+		error = DAGGLE_ERROR_MEMORY_ALLOCATION;
+		goto context_error;
+	}
+
+	master_task->work.function = prv_graph_master_task_function;
+	master_task->work.dispose = prv_graph_master_task_dispose;
+	master_task->work.context = plan;
+	master_task->execution_context = plan->context;
+	master_task->id = "graph";
+
+	prv_plan_schedule(plan, master_task, sink);
+
+	// As if the tasks were added with daggle_task_add_subgraph.
+	master_task->num_subtasks += plan->num_scheduled;
+	atomic_fetch_add(&master_task->num_pending_subtasks, plan->num_scheduled);
+
+	if (plan->num_scheduled > 0) {
+		master_task->priority = plan->roots[0]->priority;
+		sink->priority = master_task->priority;
+
+		master_task->dependants = plan->roots;
+		master_task->num_dependants = plan->num_roots;
+		master_task->dependants_capacity = 0;
+
+		atomic_store(&sink->num_pending_dependencies, plan->num_leaves);
+	} else {
+		// Nothing has changed, the sink finishes the run right away.
+		master_task->inline_dependants[0] = sink;
+		master_task->num_dependants = 1;
+
+		atomic_store(&sink->num_pending_dependencies, 1);
+	}
+
+	atomic_store(&plan->executing, true);
+
+	*out_task = master_task;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+
+context_error:
+	execution_context_end(plan->context);
+
+	RETURN_STATUS(error);
+}
+
+daggle_error_code_t
+plan_taskify(struct graph_s* graph, execution_context_t* context,
+	task_t** out_task)
+{
+	ASSERT_PARAMETER(graph);
+	ASSERT_PARAMETER(context);
+	ASSERT_OUTPUT_PARAMETER(out_task);
+
+	plan_t* plan = malloc(sizeof *plan);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(plan);
+
+	plan_init(graph, context, plan);
+	plan->is_transient = true;
+
+	daggle_error_code_t error = plan_instantiate(plan, out_task);
+	if (error != DAGGLE_SUCCESS) {
+		plan_destroy(plan);
+		free(plan);
+		RETURN_STATUS(error);
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
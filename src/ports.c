@@ -1,5 +1,8 @@
 #include "ports.h"
 
+#include "execution_context.h"
+#include "graph.h"
+#include "instance.h"
 #include "node.h"
 #include "resource_container.h"
 #include "stdlib.h"
@@ -12,12 +15,18 @@ port_destroy(port_t* port)
 {
 	ASSERT_PARAMETER(port);
 
-	free((char*)port->name_hash.name);
-
 	if (port->port_variant != DAGGLE_PORT_PARAMETER) {
 		daggle_port_disconnect(port);
 	}
 
+	port_release(port);
+}
+
+void
+port_release(port_t* port)
+{
+	ASSERT_PARAMETER(port);
+
 	if (port->port_variant == DAGGLE_PORT_OUTPUT) {
 		dynamic_array_destroy(&port->variant.output.links);
 	}
@@ -34,24 +43,68 @@ port_init(daggle_node_h node, const char* port_name,
 	ASSERT_PARAMETER(out_port);
 
 	port_t port = {
-		.name_hash = { 
-			.name = strdup(port_name), 
-			.hash = fnv1a_32(port_name) 
-		},
 		.owner = node,
 		.port_variant = variant
 	};
 
+	// The name is shared with every other port of the same name.
+	graph_t* graph = ((node_t*)node)->graph;
+	atom_table_intern(&graph->instance->atoms, port_name, &port.name_hash);
+
+	port.slot = graph->num_port_slots++;
+
 	daggle_instance_h instance;
-	daggle_graph_get_daggle(((node_t*)node)->graph, &instance);
+	daggle_graph_get_daggle(graph, &instance);
 	data_container_init(instance, &port.value);
 
 	if (variant == DAGGLE_PORT_INPUT) {
 		port.variant.input.link = NULL;
 		port.variant.input.behavior = DAGGLE_INPUT_BEHAVIOR_REFERENCE;
+		port.variant.input.link_index = 0;
 	} else if (variant == DAGGLE_PORT_OUTPUT) {
 		dynamic_array_init(0, sizeof(port_t*), &port.variant.output.links);
 	}
 
 	*out_port = port;
 }
+
+// Where the value of an unlinked input comes from: the value set for the
+// context, or the default value stored in the port.
+data_container_t*
+prv_input_get_unlinked_source(port_t* port, execution_context_t* context)
+{
+	context_port_t* state = execution_context_get_port(context, port);
+
+	if (state && data_container_has_value(&state->value)) {
+		return &state->value;
+	}
+
+	return &port->value;
+}
+
+data_container_t*
+port_get_container(port_t* port, execution_context_t* context)
+{
+	ASSERT_PARAMETER(port);
+	ASSERT_PARAMETER(context);
+
+	switch (port->port_variant) {
+	case DAGGLE_PORT_INPUT: {
+		// Inputs with an edge provide the value of the linked output.
+		port_t* link = port->variant.input.link;
+		if (link) {
+			context_port_t* state = execution_context_get_port(context, link);
+			return state ? &state->value : NULL;
+		}
+
+		return prv_input_get_unlinked_source(port, context);
+	}
+	case DAGGLE_PORT_OUTPUT: {
+		context_port_t* state = execution_context_get_port(context, port);
+		return state ? &state->value : NULL;
+	}
+	case DAGGLE_PORT_PARAMETER:
+	default:
+		return &port->value;
+	}
+}
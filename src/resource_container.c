@@ -1,6 +1,7 @@
 #include "resource_container.h"
 
 #include "instance.h"
+#include "stdalign.h"
 #include "stdlib.h"
 #include "stdint.h"
 #include "string.h"
@@ -10,16 +11,108 @@
 #include "stddef.h"
 #include <string.h>
 
+void
+prv_name_hash_index_init(uint64_t offset, name_hash_index_t* index)
+{
+	index->slots = NULL;
+	index->num_slots = 0;
+	index->num_items = 0;
+	index->offset = offset;
+}
+
+name_with_hash_t*
+prv_name_hash_index_item_name(const name_hash_index_t* index, void* item)
+{
+	return (name_with_hash_t*)((unsigned char*)item + index->offset);
+}
+
+// Slot holding the item with the name, or the empty slot where it would go.
+void**
+prv_name_hash_index_probe(const name_hash_index_t* index, const char* name,
+	uint32_t hash)
+{
+	uint64_t mask = index->num_slots - 1;
+
+	for (uint64_t i = hash & mask;; i = (i + 1) & mask) {
+		void** slot = index->slots + i;
+		if (!*slot) {
+			return slot;
+		}
+
+		name_with_hash_t* nh = prv_name_hash_index_item_name(index, *slot);
+		if (nh->hash == hash && !strcmp(name, nh->name)) {
+			return slot;
+		}
+	}
+}
+
+daggle_error_code_t
+prv_name_hash_index_grow(name_hash_index_t* index)
+{
+	uint64_t num_slots = index->num_slots ? index->num_slots * 2 : 16;
+
+	void** slots = calloc(num_slots, sizeof(void*));
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(slots);
+
+	void** old_slots = index->slots;
+	uint64_t old_num_slots = index->num_slots;
+
+	index->slots = slots;
+	index->num_slots = num_slots;
+
+	for (uint64_t i = 0; i < old_num_slots; ++i) {
+		if (!old_slots[i]) {
+			continue;
+		}
+
+		name_with_hash_t* nh
+			= prv_name_hash_index_item_name(index, old_slots[i]);
+		*prv_name_hash_index_probe(index, nh->name, nh->hash) = old_slots[i];
+	}
+
+	free(old_slots);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+// NULL if there is no item with the name.
+void*
+prv_name_hash_index_find(const name_hash_index_t* index, const char* name)
+{
+	if (index->num_items == 0) {
+		return NULL;
+	}
+
+	return *prv_name_hash_index_probe(index, name, fnv1a_32(name));
+}
+
+daggle_error_code_t
+prv_name_hash_index_insert(name_hash_index_t* index, void* item)
+{
+	// Keep at most half of the slots in use, so probes stay short.
+	if ((index->num_items + 1) * 2 > index->num_slots) {
+		RETURN_IF_ERROR(prv_name_hash_index_grow(index));
+	}
+
+	name_with_hash_t* nh = prv_name_hash_index_item_name(index, item);
+	*prv_name_hash_index_probe(index, nh->name, nh->hash) = item;
+	++index->num_items;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
 void
 resource_container_init(resource_container_t* resource_container)
 {
 	ASSERT_PARAMETER(resource_container);
 
-	// Hot reloading could be supported, if these were to use pointers.
-	// It is currently not reliably possible, as the address would change
-	// if the array is resized.
-	dynamic_array_init(0, sizeof(node_info_t), &resource_container->nodes);
-	dynamic_array_init(0, sizeof(type_info_t), &resource_container->types);
+	dynamic_array_init(0, sizeof(node_info_t*), &resource_container->nodes);
+	dynamic_array_init(0, sizeof(type_info_t*), &resource_container->types);
+
+	prv_name_hash_index_init(offsetof(node_info_t, name_hash),
+		&resource_container->node_index);
+	prv_name_hash_index_init(offsetof(type_info_t, name_hash),
+		&resource_container->type_index);
 }
 
 void
@@ -28,18 +121,50 @@ resource_container_destroy(resource_container_t* resource_container)
 	ASSERT_PARAMETER(resource_container);
 
 	for (uint64_t i = 0; i < resource_container->nodes.length; ++i) {
-		node_info_t* info = dynamic_array_at(&resource_container->nodes, i);
-		free((char*)info->name_hash.name);
+		node_info_t** info = dynamic_array_at(&resource_container->nodes, i);
+		free(*info);
 	}
 
 	dynamic_array_destroy(&resource_container->nodes);
+	free(resource_container->node_index.slots);
 
 	for (uint64_t i = 0; i < resource_container->types.length; ++i) {
-		type_info_t* info = dynamic_array_at(&resource_container->types, i);
-		free((char*)info->name_hash.name);
+		type_info_t** info = dynamic_array_at(&resource_container->types, i);
+
+		if ((*info)->pool_max_bytes > 0) {
+			pthread_mutex_destroy(&(*info)->pool_lock);
+			dynamic_array_destroy(&(*info)->pool);
+		}
+
+		free(*info);
 	}
 
 	dynamic_array_destroy(&resource_container->types);
+	free(resource_container->type_index.slots);
+}
+
+// Take the ownership of an info allocated with malloc, and index it by the
+// interned name. The first registration of a name is kept.
+daggle_error_code_t
+prv_resource_container_add(dynamic_array_t* array, name_hash_index_t* index,
+	void* info)
+{
+	name_with_hash_t* nh = prv_name_hash_index_item_name(index, info);
+
+	if (prv_name_hash_index_find(index, nh->name)) {
+		LOG_FMT(LOG_TAG_WARN, "%s is already registered", nh->name);
+		free(info);
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	daggle_error_code_t error = dynamic_array_push(array, &info);
+	if (error != DAGGLE_SUCCESS) {
+		free(info);
+		RETURN_STATUS(error);
+	}
+
+	// Stays in the array to be freed, even if it can't be indexed.
+	RETURN_STATUS(prv_name_hash_index_insert(index, info));
 }
 
 daggle_error_code_t
@@ -50,27 +175,33 @@ daggle_plugin_register_node(daggle_instance_h instance,
 	REQUIRE_PARAMETER(node_type);
 	REQUIRE_PARAMETER(declare);
 
-	node_info_t info = {
-		.name_hash = {
-			.name = strdup(node_type), 
-			.hash = fnv1a_32(node_type)
-		},
-		.declare = declare,
-	};
+	instance_t* instance_impl = instance;
 
-	// LOG_FMT_COND_DEBUG("Registered node %s", node_type);
+	node_info_t* info = malloc(sizeof *info);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(info);
 
-	resource_container_t* container = &((instance_t*)instance)->plugin_manager.res;
-	RETURN_IF_ERROR(dynamic_array_push(&container->nodes, &info));
+	daggle_error_code_t error
+		= atom_table_intern(&instance_impl->atoms, node_type, &info->name_hash);
+	if (error != DAGGLE_SUCCESS) {
+		free(info);
+		RETURN_STATUS(error);
+	}
 
-	RETURN_STATUS(DAGGLE_SUCCESS);
+	info->declare = declare;
+	atomic_init(&info->average_duration_ns, 0);
+
+	// LOG_FMT_COND_DEBUG("Registered node %s", node_type);
+
+	resource_container_t* container = &instance_impl->plugin_manager.res;
+	RETURN_STATUS(prv_resource_container_add(&container->nodes,
+		&container->node_index, info));
 }
 
 daggle_error_code_t
 daggle_plugin_register_type(daggle_instance_h instance,
 	const char* type_name, daggle_data_clone_fn cloner,
 	daggle_data_free_fn freer, daggle_data_serialize_fn serializer,
-	daggle_data_deserialize_fn deserializer)
+	daggle_data_deserialize_fn deserializer, daggle_data_hash_fn hasher)
 {
 	REQUIRE_PARAMETER(instance);
 	REQUIRE_PARAMETER(type_name);
@@ -79,53 +210,206 @@ daggle_plugin_register_type(daggle_instance_h instance,
 	REQUIRE_PARAMETER(serializer);
 	REQUIRE_PARAMETER(deserializer);
 
-	type_info_t info = {
-		.name_hash = { 
-			.name = strdup(type_name), 
-			.hash = fnv1a_32(type_name) 
-		},
+	instance_t* instance_impl = instance;
+
+	type_info_t* info = malloc(sizeof *info);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(info);
+
+	*info = (type_info_t) {
 		.cloner = cloner,
 		.freer = freer,
 		.serializer = serializer,
 		.deserializer = deserializer,
+		.hasher = hasher,
 	};
 
+	daggle_error_code_t error
+		= atom_table_intern(&instance_impl->atoms, type_name, &info->name_hash);
+	if (error != DAGGLE_SUCCESS) {
+		free(info);
+		RETURN_STATUS(error);
+	}
+
 	// LOG_FMT_COND_DEBUG("Registered type %s (%u)", info.name, info.hash);
 
-	resource_container_t* container = &((instance_t*)instance)->plugin_manager.res;
-	RETURN_IF_ERROR(dynamic_array_push(&container->types, &info));
+	resource_container_t* container = &instance_impl->plugin_manager.res;
+	RETURN_STATUS(prv_resource_container_add(&container->types,
+		&container->type_index, info));
+}
+
+daggle_error_code_t
+daggle_plugin_register_type_layout(daggle_instance_h instance,
+	const char* type_name, uint64_t size, uint64_t alignment,
+	bool is_trivially_copyable)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type_name);
+
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		LOG(LOG_TAG_ERROR, "Alignment is not a power of two");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	instance_t* instance_impl = instance;
+
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&instance_impl->plugin_manager.res, type_name, &info));
+
+	info->size = size;
+	info->alignment = alignment;
+	info->is_trivially_copyable = is_trivially_copyable;
+	info->is_inline = is_trivially_copyable && size > 0
+		&& size <= DAGGLE_INLINE_VALUE_SIZE
+		&& alignment <= alignof(max_align_t);
 
 	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
-// Search dynamic_array_t of structs where the member at offset is name_with_hash_t
 daggle_error_code_t
-prv_name_hash_array_get_item(dynamic_array_t* array, uint64_t offset,
-	const char* name, void** out_item)
+daggle_plugin_register_type_shared(daggle_instance_h instance,
+	const char* type_name)
 {
-	ASSERT_PARAMETER(array);
-	ASSERT_PARAMETER(name);
-	ASSERT_OUTPUT_PARAMETER(out_item);
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type_name);
+
+	instance_t* instance_impl = instance;
+
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&instance_impl->plugin_manager.res, type_name, &info));
+
+	info->is_shared = true;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+daggle_error_code_t
+daggle_plugin_register_type_pool(daggle_instance_h instance,
+	const char* type_name, uint64_t max_bytes,
+	daggle_data_size_fn sizer /* nullable */)
+{
+	REQUIRE_PARAMETER(instance);
+	REQUIRE_PARAMETER(type_name);
+
+	instance_t* instance_impl = instance;
+
+	type_info_t* info;
+	RETURN_IF_ERROR(resource_container_get_type(
+		&instance_impl->plugin_manager.res, type_name, &info));
+
+	if (info->pool_max_bytes > 0 || max_bytes == 0) {
+		LOG_FMT(LOG_TAG_WARN, "%s already has a pool, or none is asked for",
+			type_name);
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	if (!sizer && info->size == 0) {
+		LOG_FMT(LOG_TAG_ERROR, "%s has no layout to measure the values by",
+			type_name);
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	dynamic_array_init(0, sizeof(type_pool_entry_t), &info->pool);
+	pthread_mutex_init(&info->pool_lock, NULL);
+	info->pool_sizer = sizer;
+	info->pool_bytes = 0;
+	info->pool_max_bytes = max_bytes;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+type_info_release_data(type_info_t* info, daggle_instance_h instance,
+	void* data)
+{
+	ASSERT_PARAMETER(info);
+	ASSERT_PARAMETER(data);
+
+	if (info->pool_max_bytes > 0) {
+		type_pool_entry_t entry = { .data = data, .size = info->size };
+		if (info->pool_sizer) {
+			entry.size = info->pool_sizer(instance, data);
+		}
+
+		pthread_mutex_lock(&info->pool_lock);
+
+		bool is_kept = entry.size <= info->pool_max_bytes - info->pool_bytes
+			&& dynamic_array_push(&info->pool, &entry) == DAGGLE_SUCCESS;
+		if (is_kept) {
+			info->pool_bytes += entry.size;
+		}
+
+		pthread_mutex_unlock(&info->pool_lock);
+
+		if (is_kept) {
+			return;
+		}
+	}
+
+	daggle_data_free_typed(instance, info, data);
+}
+
+void*
+type_info_recycle_data(type_info_t* info)
+{
+	ASSERT_PARAMETER(info);
+
+	if (info->pool_max_bytes == 0) {
+		return NULL;
+	}
+
+	void* data = NULL;
+
+	pthread_mutex_lock(&info->pool_lock);
+
+	// The most recently released value, likely still in the cache.
+	if (info->pool.length > 0) {
+		uint64_t last = info->pool.length - 1;
+		type_pool_entry_t* entry = dynamic_array_at(&info->pool, last);
+
+		data = entry->data;
+		info->pool_bytes -= entry->size;
+		dynamic_array_remove(&info->pool, last);
+	}
+
+	pthread_mutex_unlock(&info->pool_lock);
 
-	ASSERT_TRUE(array->stride >= sizeof(name_with_hash_t), 
-		"Array should contain struct with name_with_hash_t member");
+	return data;
+}
 
-	const uint32_t search_hash = fnv1a_32(name);
+void
+resource_container_drain_pools(resource_container_t* resource_container,
+	daggle_instance_h instance)
+{
+	ASSERT_PARAMETER(resource_container);
 
-	for (uint64_t i = 0; i < array->length; ++i) {
-		void* item = dynamic_array_at(array, i);
-		name_with_hash_t* nh = item + offset;
+	for (uint64_t i = 0; i < resource_container->types.length; ++i) {
+		type_info_t** info = dynamic_array_at(&resource_container->types, i);
 
-		if (nh->hash == search_hash
-			&& !strcmp(name, nh->name)) {
-			*out_item = item;
-			RETURN_STATUS(DAGGLE_SUCCESS);
+		void* data;
+		while ((data = type_info_recycle_data(*info))) {
+			daggle_data_free_typed(instance, *info, data);
 		}
 	}
+}
+
+daggle_error_code_t
+prv_name_hash_index_get_item(const name_hash_index_t* index,
+	const char* name, void** out_item)
+{
+	ASSERT_PARAMETER(index);
+	ASSERT_PARAMETER(name);
+	ASSERT_OUTPUT_PARAMETER(out_item);
+
+	void* item = prv_name_hash_index_find(index, name);
+	if (!item) {
+		LOG_FMT(LOG_TAG_ERROR, "Item %s not found", name);
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
 
-	// Not found.
-	LOG_FMT(LOG_TAG_ERROR, "Item %s not found", name);
-	RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	*out_item = item;
+	RETURN_STATUS(DAGGLE_SUCCESS);
 }
 
 daggle_error_code_t
@@ -133,11 +417,9 @@ resource_container_get_type(resource_container_t* resource_container,
 	const char* data_type, type_info_t** out_info)
 {
 	ASSERT_PARAMETER(resource_container);
-	
-	// Get the offset to the name_hash member in type_info.
-	uint64_t offset = (uint64_t)offsetof(type_info_t, name_hash);
-	RETURN_STATUS(prv_name_hash_array_get_item(&resource_container->types, offset,
-		data_type, (void*)out_info));
+
+	RETURN_STATUS(prv_name_hash_index_get_item(
+		&resource_container->type_index, data_type, (void*)out_info));
 }
 
 daggle_error_code_t
@@ -146,8 +428,50 @@ resource_container_get_node(resource_container_t* resource_container,
 {
 	ASSERT_PARAMETER(resource_container);
 
-	// Get the offset to the name_hash member in node_info.
-	uint64_t offset = (uint64_t)offsetof(node_info_t, name_hash);
-	RETURN_STATUS(prv_name_hash_array_get_item(&resource_container->nodes, offset,
-		node_type, (void*)out_info));
+	RETURN_STATUS(prv_name_hash_index_get_item(
+		&resource_container->node_index, node_type, (void*)out_info));
+}
+
+uint64_t
+type_info_hash_data(type_info_t* info, daggle_instance_h instance,
+	const void* data)
+{
+	ASSERT_PARAMETER(info);
+	ASSERT_PARAMETER(data);
+
+	// Equal bytes of different types are different values.
+	uint64_t hash = fnv1a_64(info->name_hash.name);
+
+	if (info->hasher) {
+		return hash_combine_64(hash, info->hasher(instance, data));
+	}
+
+	unsigned char* bin = NULL;
+	uint64_t len = 0;
+	info->serializer(instance, data, &bin, &len);
+
+	hash = hash_combine_64(hash, fnv1a_64_bytes(bin, len));
+	free(bin);
+
+	return hash;
+}
+
+void
+node_info_record_duration(node_info_t* info, uint64_t duration_ns)
+{
+	ASSERT_PARAMETER(info);
+
+	uint64_t average = atomic_load_explicit(&info->average_duration_ns,
+		memory_order_relaxed);
+
+	// The first run sets the average, later ones move it by an eighth.
+	// Concurrent updates may overwrite each other, which only loses samples.
+	if (average == 0) {
+		average = duration_ns;
+	} else {
+		average = average - average / 8 + duration_ns / 8;
+	}
+
+	atomic_store_explicit(&info->average_duration_ns, average > 0 ? average : 1,
+		memory_order_relaxed);
 }
@@ -65,52 +65,20 @@ prv_input_behavior_1_to_daggle(input_behavior_1_t variant)
 	}
 }
 
-// Find the flattened index of a port.
+// Find the flattened index of a port, from the flattened index of the first
+// port of each node.
 uint64_t
-prv_get_port_flat_index(const graph_t* graph, const port_t* port)
+prv_get_port_flat_index(const uint64_t* first_port_ptidx, const port_t* port)
 {
-	uint64_t counter = 0;
+	node_t* owner = port->owner;
 
-	for (int i = 0; i < graph->nodes.length; i++) {
-		node_t** node_element = dynamic_array_at(&graph->nodes, i);
-		node_t* node = *node_element;
-
-		for (int j = 0; j < node->ports.length; j++) {
-			port_t* port_element = dynamic_array_at(&node->ports, j);
-
-			if (port_element == port) {
-				return counter;
-			}
-
-			counter++;
-		}
-	}
-
-	printf("Port counting failed");
-	return UINT32_MAX;
-}
-
-// Find the node and port indices of the Nth port. Essentially reverse of the
-// above.
-void
-prv_get_flat_port_indices(uint64_t edge_ptidx, uint64_t num_nodes,
-	const node_entry_1_t* nodes, uint64_t* out_node_idx, uint64_t* out_port_idx)
-{
-	uint64_t counter = 0;
-	for (int i = 0; i < num_nodes; i++) {
-		const node_entry_1_t* node_entry = nodes + i;
-		for (int j = 0; j < node_entry->num_ports; j++) {
-			if (counter == edge_ptidx) {
-				*out_port_idx = j;
-				*out_node_idx = i;
-				return;
-			}
-
-			counter++;
-		}
+	// The ports are stored by pointer, find the position of this one.
+	uint64_t local_index = 0;
+	while (node_get_port_by_index(owner, local_index) != port) {
+		++local_index;
 	}
 
-	printf("Port counting failed");
+	return first_port_ptidx[owner->index] + local_index;
 }
 
 void
@@ -131,7 +99,7 @@ prv_write_arrays_to_bin(const dynamic_array_t* node_entries,
 
 	total_size += sizeof(graph_1_t);
 	total_size += node_entries->stride * node_entries->length;
-	total_size += node_entries->stride * port_entries->length;
+	total_size += port_entries->stride * port_entries->length;
 	total_size += string_buffer->stride * string_buffer->length;
 	total_size += data_buffer->stride * data_buffer->length;
 
@@ -162,6 +130,23 @@ prv_write_arrays_to_bin(const dynamic_array_t* node_entries,
 	*out_len = total_size;
 }
 
+// Make room for a buffer to grow to the length. The capacity is doubled, so
+// appending to the buffer takes linear time overall.
+void
+prv_reserve_buffer(dynamic_array_t* buffer, uint64_t length)
+{
+	if (length <= buffer->capacity) {
+		return;
+	}
+
+	uint64_t capacity = buffer->capacity > 0 ? buffer->capacity : 64;
+	while (capacity < length) {
+		capacity *= 2;
+	}
+
+	dynamic_array_resize(buffer, capacity);
+}
+
 void
 prv_append_string_buffer(dynamic_array_t* string_buffer, const char* source,
 	uint64_t* out_index)
@@ -173,8 +158,8 @@ prv_append_string_buffer(dynamic_array_t* string_buffer, const char* source,
 	uint64_t string_length = strlen(source) + 1;
 
 	// Add empty space the size of the string into the string buffer.
-	dynamic_array_resize(string_buffer, string_buffer->length + string_length);
-	string_buffer->length = string_buffer->capacity;
+	prv_reserve_buffer(string_buffer, start_offset + string_length);
+	string_buffer->length = start_offset + string_length;
 
 	// Copy the string into the string buffer.
 	memcpy(string_buffer->data + start_offset, source, string_length);
@@ -199,8 +184,8 @@ prv_append_data_buffer(dynamic_array_t* data_buffer,
 	uint64_t data_entry_size = sizeof(data_entry_1_t) + data_len;
 
 	// Add empty space the size of the data entry into the data buffer.
-	dynamic_array_resize(data_buffer, data_buffer->length + data_entry_size);
-	data_buffer->length = data_buffer->capacity;
+	prv_reserve_buffer(data_buffer, start_offset + data_entry_size);
+	data_buffer->length = start_offset + data_entry_size;
 
 	// Get the location of the data entry.
 	data_entry_1_t* entry = data_buffer->data + start_offset;
@@ -216,8 +201,8 @@ prv_append_data_buffer(dynamic_array_t* data_buffer,
 
 void
 prv_port_serialize_and_push(port_t* port, graph_t* graph,
-	dynamic_array_t* port_entries, dynamic_array_t* string_buffer,
-	dynamic_array_t* data_buffer)
+	const uint64_t* first_port_ptidx, dynamic_array_t* port_entries,
+	dynamic_array_t* string_buffer, dynamic_array_t* data_buffer)
 {
 	port_entry_1_t port_entry;
 
@@ -239,8 +224,8 @@ prv_port_serialize_and_push(port_t* port, graph_t* graph,
 			= prv_input_behavior_daggle_to_1(port->variant.input.behavior);
 
 		if (port->variant.input.link) {
-			port_entry.edge_ptidx
-				= prv_get_port_flat_index(graph, port->variant.input.link);
+			port_entry.edge_ptidx = prv_get_port_flat_index(first_port_ptidx,
+				port->variant.input.link);
 		}
 	}
 
@@ -262,8 +247,9 @@ prv_port_serialize_and_push(port_t* port, graph_t* graph,
 
 void
 prv_node_serialize_and_push(node_t* node, graph_t* graph,
-	dynamic_array_t* node_entries, dynamic_array_t* port_entries,
-	dynamic_array_t* string_buffer, dynamic_array_t* data_buffer)
+	const uint64_t* first_port_ptidx, dynamic_array_t* node_entries,
+	dynamic_array_t* port_entries, dynamic_array_t* string_buffer,
+	dynamic_array_t* data_buffer)
 {
 	node_entry_1_t entry;
 
@@ -284,9 +270,9 @@ prv_node_serialize_and_push(node_t* node, graph_t* graph,
 
 	// Serialize and push the ports of the node.
 	for (int j = 0; j < node->ports.length; j++) {
-		port_t* port_element = dynamic_array_at(&node->ports, j);
-		prv_port_serialize_and_push(port_element, graph, port_entries,
-			string_buffer, data_buffer);
+		port_t* port_element = node_get_port_by_index(node, j);
+		prv_port_serialize_and_push(port_element, graph, first_port_ptidx,
+			port_entries, string_buffer, data_buffer);
 	}
 }
 
@@ -303,17 +289,32 @@ daggle_graph_serialize(daggle_graph_h handle, unsigned char** out_bin,
 
 	const uint64_t num_nodes = graph->nodes.length;
 
+	// The ports are stored node by node, so the flattened index of a port is
+	// the number of ports before its node plus its index in the node.
+	uint64_t* first_port_ptidx = malloc(sizeof(uint64_t) * (num_nodes + 1));
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(first_port_ptidx);
+
+	first_port_ptidx[0] = 0;
+	for (uint64_t i = 0; i < num_nodes; i++) {
+		node_t** node_element = dynamic_array_at(&graph->nodes, i);
+		first_port_ptidx[i + 1]
+			= first_port_ptidx[i] + (*node_element)->ports.length;
+	}
+
 	dynamic_array_init(num_nodes, sizeof(node_entry_1_t), &node_entries);
-	dynamic_array_init(0, sizeof(node_entry_1_t), &port_entries);
+	dynamic_array_init(first_port_ptidx[num_nodes], sizeof(port_entry_1_t),
+		&port_entries);
 	dynamic_array_init(0, sizeof(char), &string_buffer);
 	dynamic_array_init(0, sizeof(unsigned char), &data_buffer);
 
-	for (int i = 0; i < num_nodes; i++) {
+	for (uint64_t i = 0; i < num_nodes; i++) {
 		node_t** node_element = dynamic_array_at(&graph->nodes, i);
-		prv_node_serialize_and_push(*node_element, graph, &node_entries,
-			&port_entries, &string_buffer, &data_buffer);
+		prv_node_serialize_and_push(*node_element, graph, first_port_ptidx,
+			&node_entries, &port_entries, &string_buffer, &data_buffer);
 	}
 
+	free(first_port_ptidx);
+
 	prv_write_arrays_to_bin(&node_entries, &port_entries, &string_buffer,
 		&data_buffer, out_bin, out_len);
 
@@ -339,39 +340,42 @@ prv_get_port_with_global_index(graph_t* graph, prv_u64_tuple_t* port_index_map,
 	node_t* node
 		= *((node_t**)dynamic_array_at(&graph->nodes, indices->node_index));
 
-	port_t* port = dynamic_array_at(&node->ports, indices->port_index);
+	port_t* port = node_get_port_by_index(node, indices->port_index);
 
 	return port;
 }
 
 void
 prv_deserialize_port(daggle_instance_h instance, node_t* node,
-	uint64_t global_index, uint64_t local_index, const port_entry_1_t* ports,
-	char* strings, unsigned char* datas)
+	uint64_t global_index, const port_entry_1_t* ports, char* strings,
+	unsigned char* datas)
 {
-	port_t* port_element = dynamic_array_at(&node->ports, local_index);
+	port_t* port_element = graph_alloc_port(node->graph);
 
 	const port_entry_1_t* port_entry = ports + global_index;
 	const char* port_name = strings + port_entry->name_stoff;
 
-	printf("- Port: %s\n", port_name);
-	printf("  - Index: port[%llu]\n", global_index);
+	LOG_FMT_COND_DEBUG("Port %s, index %llu", port_name, global_index);
 
 	const char* pvarnames[] = { "INPUT", "OUTPUT", "PARAMETER" };
-	printf("  - Variant: %s\n", pvarnames[port_entry->port_variant]);
+	LOG_FMT_COND_DEBUG("- Variant: %s", pvarnames[port_entry->port_variant]);
 
 	daggle_port_variant_t variant;
 	variant = prv_port_variant_1_to_daggle(port_entry->port_variant);
 
 	port_init(node, port_name, variant, port_element);
 
+	// The ports are added in order, each one gets the next local index.
+	node_add_port(node, port_element);
+
 	// Deserialize input port variant
 	if (port_entry->port_variant == INPUT) {
 		const char* ivarnames[] = { "REFERENCE", "ACQUIRE" };
-		printf("  - Input: %s\n", ivarnames[port_entry->port_specific.input]);
+		LOG_FMT_COND_DEBUG("- Input: %s",
+			ivarnames[port_entry->port_specific.input]);
 
 		if (port_entry->edge_ptidx != UINT64_MAX) {
-			printf("  - Link: port[%llu]\n", port_entry->edge_ptidx);
+			LOG_FMT_COND_DEBUG("- Link: port %llu", port_entry->edge_ptidx);
 		}
 
 		daggle_input_behavior_t input_behavior;
@@ -387,7 +391,7 @@ prv_deserialize_port(daggle_instance_h instance, node_t* node,
 
 		const char* data_type = strings + data_entry->type_stoff;
 
-		printf("  - Data: %s (%lluB)\n", data_type, data_entry->size);
+		LOG_FMT_COND_DEBUG("- Data: %s (%lluB)", data_type, data_entry->size);
 
 		void* deserialized_data = NULL;
 		daggle_data_deserialize(instance, data_type, data_entry->bytes,
@@ -428,8 +432,8 @@ prv_graph_deserialize_1(daggle_instance_h instance, const unsigned char* bin,
 	graph_t* graph;
 	daggle_graph_create(instance, (daggle_graph_h)&graph);
 
-	printf("Version: %llu\nNodes: %llu\nPorts: %llu\n", version, num_nodes,
-		num_ports);
+	LOG_FMT_COND_DEBUG("Version %llu, %llu nodes, %llu ports", version,
+		num_nodes, num_ports);
 
 	for (int node_index = 0; node_index < num_nodes; node_index++) {
 		const node_entry_1_t* node_entry = nodes + node_index;
@@ -437,24 +441,30 @@ prv_graph_deserialize_1(daggle_instance_h instance, const unsigned char* bin,
 		const char* node_name = strings + node_entry->name_stoff;
 		const char* node_type = strings + node_entry->type_stoff;
 
-		printf("Node: %s (%s)\n", node_name, node_type);
+		LOG_FMT_COND_DEBUG("Node %s (%s)", node_name, node_type);
 
 		// Construct node
 		node_info_t* info;
 		resource_container_get_node(&graph->instance->plugin_manager.res,
 			node_type, &info);
 
-		node_t* node = malloc(sizeof *node);
+		node_t* node = graph_alloc_node(graph);
 
 		node->instance_task = NULL;
 		node->info = info;
 		node->graph = graph;
+		node->slot = graph->num_node_slots++;
+		node->version = 1;
+		node->is_volatile = false;
+		node->is_memoized = false;
 		node->custom_context = NULL;
 		node->custom_context_destructor = NULL;
 
-		// Initialize port array
-		dynamic_array_init(node_entry->num_ports, sizeof(port_t), &node->ports);
-		node->ports.length = node_entry->num_ports;
+		// Initialize port arrays
+		dynamic_array_init(node_entry->num_ports, sizeof(port_t*),
+			&node->ports);
+		dynamic_array_init(node_entry->num_ports, sizeof(port_t*),
+			&node->ports_by_id);
 
 		for (int local_index = 0; local_index < node_entry->num_ports;
 			local_index++) {
@@ -464,10 +474,11 @@ prv_graph_deserialize_1(daggle_instance_h instance, const unsigned char* bin,
 			port_index_map[global_index].node_index = node_index;
 			port_index_map[global_index].port_index = local_index;
 
-			prv_deserialize_port(instance, node, global_index, local_index,
-				ports, strings, datas);
+			prv_deserialize_port(instance, node, global_index, ports,
+				strings, datas);
 		}
 
+		node->index = graph->nodes.length;
 		dynamic_array_push(&graph->nodes, &node);
 	}
 
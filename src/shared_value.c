@@ -0,0 +1,105 @@
+#include "shared_value.h"
+
+#include "stdlib.h"
+#include "utility/return_macro.h"
+
+shared_value_t*
+shared_value_create(daggle_instance_h instance, type_info_t* info,
+	void* data)
+{
+	ASSERT_PARAMETER(instance);
+	ASSERT_PARAMETER(info);
+
+	shared_value_t* value = malloc(sizeof *value);
+	if (!value) {
+		return NULL;
+	}
+
+	atomic_init(&value->num_references, 1);
+	value->info = info;
+	value->instance = instance;
+	value->data = data;
+
+	return value;
+}
+
+void
+shared_value_retain(shared_value_t* value)
+{
+	ASSERT_PARAMETER(value);
+
+	atomic_fetch_add_explicit(&value->num_references, 1,
+		memory_order_relaxed);
+}
+
+void
+shared_value_release(shared_value_t* value)
+{
+	ASSERT_PARAMETER(value);
+
+	// The last holder sees every write made through the other references.
+	if (atomic_fetch_sub_explicit(&value->num_references, 1,
+			memory_order_acq_rel)
+		!= 1) {
+		return;
+	}
+
+	if (value->data) {
+		type_info_release_data(value->info, value->instance, value->data);
+	}
+
+	free(value);
+}
+
+void*
+shared_value_take(shared_value_t* value)
+{
+	ASSERT_PARAMETER(value);
+
+	if (atomic_load_explicit(&value->num_references, memory_order_acquire)
+		== 1) {
+		void* data = value->data;
+		free(value);
+		return data;
+	}
+
+	void* copy = NULL;
+	daggle_data_clone_typed(value->instance, value->info, value->data, &copy);
+
+	shared_value_release(value);
+
+	return copy;
+}
+
+daggle_error_code_t
+shared_value_make_mutable(shared_value_t** value, void** out_data)
+{
+	ASSERT_PARAMETER(value);
+	ASSERT_OUTPUT_PARAMETER(out_data);
+
+	shared_value_t* shared = *value;
+
+	if (atomic_load_explicit(&shared->num_references, memory_order_acquire)
+		== 1) {
+		*out_data = shared->data;
+		RETURN_STATUS(DAGGLE_SUCCESS);
+	}
+
+	void* copy = NULL;
+	RETURN_IF_ERROR(daggle_data_clone_typed(shared->instance, shared->info,
+		shared->data, &copy));
+
+	shared_value_t* unshared
+		= shared_value_create(shared->instance, shared->info, copy);
+	if (!unshared) {
+		daggle_data_free_typed(shared->instance, shared->info, copy);
+		RETURN_STATUS(DAGGLE_ERROR_MEMORY_ALLOCATION);
+	}
+
+	shared_value_release(shared);
+
+	*value = unshared;
+	*out_data = copy;
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
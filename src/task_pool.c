@@ -0,0 +1,148 @@
+#include "task.h"
+
+#include "stdlib.h"
+#include "utility/return_macro.h"
+
+// Number of tasks allocated at once when a pool runs dry.
+#define TASK_POOL_SLAB_SIZE 64
+
+// Number of tasks collected before a batch is sent back to its owner.
+#define TASK_POOL_BATCH_SIZE 32
+
+void
+task_pool_init(task_pool_t* pool)
+{
+	ASSERT_PARAMETER(pool);
+
+	pool->free_list = NULL;
+	dynamic_array_init(0, sizeof(void*), &pool->slabs);
+
+	pool->batch_pool = NULL;
+	pool->batch_head = NULL;
+	pool->batch_tail = NULL;
+	pool->batch_length = 0;
+
+	atomic_init(&pool->remote_free_list, NULL);
+}
+
+void
+task_pool_destroy(task_pool_t* pool)
+{
+	ASSERT_PARAMETER(pool);
+
+	task_pool_flush(pool);
+
+	for (uint64_t i = 0; i < pool->slabs.length; ++i) {
+		void** slab = dynamic_array_at(&pool->slabs, i);
+		free(*slab);
+	}
+
+	dynamic_array_destroy(&pool->slabs);
+	pool->free_list = NULL;
+	atomic_store(&pool->remote_free_list, NULL);
+}
+
+// Push a chain of tasks onto the remote list of their owner. The owner only
+// ever takes the whole list, so the push can't suffer from ABA.
+void
+prv_task_pool_push_remote(task_pool_t* pool, task_t* head, task_t* tail)
+{
+	task_t* top = atomic_load_explicit(&pool->remote_free_list,
+		memory_order_relaxed);
+
+	do {
+		atomic_store_explicit(&tail->next, top, memory_order_relaxed);
+	} while (!atomic_compare_exchange_weak_explicit(&pool->remote_free_list,
+		&top, head, memory_order_release, memory_order_relaxed));
+}
+
+task_t*
+task_pool_alloc(task_pool_t* pool)
+{
+	ASSERT_PARAMETER(pool);
+
+	if (!pool->free_list) {
+		// Take everything the other threads have returned.
+		pool->free_list = atomic_exchange_explicit(&pool->remote_free_list,
+			NULL, memory_order_acquire);
+	}
+
+	if (!pool->free_list) {
+		task_t* slab = aligned_alloc(alignof(task_t),
+			sizeof(task_t) * TASK_POOL_SLAB_SIZE);
+		if (!slab) {
+			return NULL;
+		}
+
+		if (dynamic_array_push(&pool->slabs, &slab) != DAGGLE_SUCCESS) {
+			free(slab);
+			return NULL;
+		}
+
+		for (uint64_t i = 0; i < TASK_POOL_SLAB_SIZE; ++i) {
+			slab[i].pool = pool;
+			atomic_init(&slab[i].next,
+				i + 1 < TASK_POOL_SLAB_SIZE ? slab + i + 1 : NULL);
+		}
+
+		pool->free_list = slab;
+	}
+
+	task_t* task = pool->free_list;
+	pool->free_list = atomic_load_explicit(&task->next, memory_order_relaxed);
+
+	return task;
+}
+
+void
+task_pool_free_local(task_pool_t* pool, task_t* task)
+{
+	ASSERT_PARAMETER(pool);
+	ASSERT_PARAMETER(task);
+	ASSERT_TRUE(task->pool == pool, "Task is owned by another pool");
+
+	atomic_store_explicit(&task->next, pool->free_list, memory_order_relaxed);
+	pool->free_list = task;
+}
+
+void
+task_pool_free_remote(task_pool_t* local, task_t* task)
+{
+	ASSERT_PARAMETER(task);
+
+	if (!local) {
+		prv_task_pool_push_remote(task->pool, task, task);
+		return;
+	}
+
+	// A batch only holds tasks of a single pool.
+	if (local->batch_pool != task->pool) {
+		task_pool_flush(local);
+		local->batch_pool = task->pool;
+		local->batch_tail = task;
+	}
+
+	atomic_store_explicit(&task->next, local->batch_head,
+		memory_order_relaxed);
+	local->batch_head = task;
+
+	if (++local->batch_length == TASK_POOL_BATCH_SIZE) {
+		task_pool_flush(local);
+	}
+}
+
+void
+task_pool_flush(task_pool_t* pool)
+{
+	ASSERT_PARAMETER(pool);
+
+	if (pool->batch_length > 0) {
+		prv_task_pool_push_remote(pool->batch_pool, pool->batch_head,
+			pool->batch_tail);
+	}
+
+	pool->batch_pool = NULL;
+	pool->batch_head = NULL;
+	pool->batch_tail = NULL;
+	pool->batch_length = 0;
+}
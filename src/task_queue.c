@@ -0,0 +1,111 @@
+#include "task_queue.h"
+
+#include "utility/return_macro.h"
+
+void
+task_queue_init(task_queue_t* queue)
+{
+	ASSERT_PARAMETER(queue);
+
+	atomic_init(&queue->stub.next, NULL);
+	atomic_init(&queue->back, &queue->stub);
+	queue->front = &queue->stub;
+	atomic_flag_clear(&queue->consumer_lock);
+	atomic_init(&queue->size, 0);
+}
+
+void
+prv_task_queue_push(task_queue_t* queue, task_t* task)
+{
+	atomic_store_explicit(&task->next, NULL, memory_order_relaxed);
+
+	// The queue is briefly unlinked between the exchange and the store, the
+	// consumer treats that as empty.
+	task_t* previous
+		= atomic_exchange_explicit(&queue->back, task, memory_order_acq_rel);
+	atomic_store_explicit(&previous->next, task, memory_order_release);
+}
+
+void
+task_queue_enqueue(task_queue_t* queue, task_t* task)
+{
+	ASSERT_PARAMETER(queue);
+	ASSERT_PARAMETER(task);
+
+	// Counted before it is linked, so the queue is never seen as empty while
+	// it is not.
+	atomic_fetch_add_explicit(&queue->size, 1, memory_order_seq_cst);
+	prv_task_queue_push(queue, task);
+}
+
+task_t*
+prv_task_queue_pop(task_queue_t* queue)
+{
+	task_t* front = queue->front;
+	task_t* next = atomic_load_explicit(&front->next, memory_order_acquire);
+
+	// Skip over the stub.
+	if (front == &queue->stub) {
+		if (!next) {
+			return NULL;
+		}
+
+		queue->front = next;
+		front = next;
+		next = atomic_load_explicit(&front->next, memory_order_acquire);
+	}
+
+	if (next) {
+		queue->front = next;
+		return front;
+	}
+
+	// The front is the last task, unless a producer is mid-push.
+	if (front != atomic_load_explicit(&queue->back, memory_order_acquire)) {
+		return NULL;
+	}
+
+	// Put the stub back behind the last task, so it can be taken.
+	prv_task_queue_push(queue, &queue->stub);
+
+	next = atomic_load_explicit(&front->next, memory_order_acquire);
+	if (next) {
+		queue->front = next;
+		return front;
+	}
+
+	return NULL;
+}
+
+task_t*
+task_queue_try_dequeue(task_queue_t* queue)
+{
+	ASSERT_PARAMETER(queue);
+
+	if (atomic_load_explicit(&queue->size, memory_order_relaxed) == 0) {
+		return NULL;
+	}
+
+	if (atomic_flag_test_and_set_explicit(&queue->consumer_lock,
+			memory_order_acquire)) {
+		return NULL;
+	}
+
+	task_t* task = prv_task_queue_pop(queue);
+
+	atomic_flag_clear_explicit(&queue->consumer_lock, memory_order_release);
+
+	if (task) {
+		atomic_fetch_sub_explicit(&queue->size, 1, memory_order_relaxed);
+	}
+
+	return task;
+}
+
+bool
+task_queue_is_empty(task_queue_t* queue)
+{
+	ASSERT_PARAMETER(queue);
+
+	return atomic_load_explicit(&queue->size, memory_order_seq_cst) == 0;
+}
@@ -0,0 +1,136 @@
+#ifdef __linux__
+#define _GNU_SOURCE
+#include "dirent.h"
+#include "sched.h"
+#include "unistd.h"
+#endif
+
+#include "utility/topology.h"
+
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "utility/return_macro.h"
+
+uint64_t
+topology_get_num_cpus(void)
+{
+#ifdef __linux__
+	long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_cpus > 0) {
+		return num_cpus;
+	}
+#endif
+
+	return 1;
+}
+
+uint64_t
+topology_get_cpu_id_limit(void)
+{
+#ifdef __linux__
+	// A list of ranges, such as 0-3,8-11, ending with the highest id.
+	uint64_t limit = 0;
+
+	FILE* file = fopen("/sys/devices/system/cpu/possible", "r");
+	if (file) {
+		char list[256];
+		if (fgets(list, sizeof list, file)) {
+			char* last = list;
+			for (char* c = list; *c; ++c) {
+				if (*c == '-' || *c == ',') {
+					last = c + 1;
+				}
+			}
+
+			limit = strtoull(last, NULL, 10) + 1;
+		}
+
+		fclose(file);
+	}
+
+	if (limit == 0) {
+		long num_cpus = sysconf(_SC_NPROCESSORS_CONF);
+		limit = num_cpus > 0 ? num_cpus : 1;
+	}
+
+	return limit < CPU_SETSIZE ? limit : CPU_SETSIZE;
+#else
+	return 1;
+#endif
+}
+
+uint64_t
+topology_get_cpu_node(uint64_t cpu)
+{
+#ifdef __linux__
+	// The CPU directory contains a nodeN link to the NUMA node it belongs to.
+	char path[64];
+	snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%llu",
+		(unsigned long long)cpu);
+
+	DIR* dir = opendir(path);
+	if (!dir) {
+		return TOPOLOGY_NO_NODE;
+	}
+
+	uint64_t node = 0;
+	struct dirent* entry;
+	while ((entry = readdir(dir))) {
+		if (strncmp(entry->d_name, "node", 4) == 0
+			&& entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+			node = strtoull(entry->d_name + 4, NULL, 10);
+			break;
+		}
+	}
+
+	closedir(dir);
+
+	return node;
+#else
+	return 0;
+#endif
+}
+
+uint64_t
+topology_get_current_cpu(void)
+{
+#ifdef __linux__
+	int cpu = sched_getcpu();
+	if (cpu >= 0) {
+		return cpu;
+	}
+#endif
+
+	return 0;
+}
+
+daggle_error_code_t
+topology_pin_thread(pthread_t thread, const uint64_t* cpus, uint64_t num_cpus)
+{
+	ASSERT_PARAMETER(cpus);
+
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+
+	for (uint64_t i = 0; i < num_cpus; ++i) {
+		if (cpus[i] >= CPU_SETSIZE) {
+			LOG(LOG_TAG_WARN, "CPU id is out of range of the CPU set");
+			RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+		}
+
+		CPU_SET(cpus[i], &set);
+	}
+
+	if (pthread_setaffinity_np(thread, sizeof set, &set) != 0) {
+		LOG(LOG_TAG_WARN, "Failed to set the CPU affinity of a worker");
+		RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+#else
+	LOG(LOG_TAG_WARN, "CPU pinning is not supported on this platform");
+	RETURN_STATUS(DAGGLE_ERROR_UNKNOWN);
+#endif
+}
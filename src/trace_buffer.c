@@ -0,0 +1,144 @@
+#include "trace_buffer.h"
+
+#include "stdlib.h"
+#include "utility/return_macro.h"
+
+daggle_error_code_t
+trace_buffer_init(uint64_t capacity, trace_buffer_t* buffer)
+{
+	ASSERT_PARAMETER(buffer);
+
+	buffer->events = NULL;
+	buffer->capacity = 0;
+	atomic_init(&buffer->num_recorded, 0);
+	atomic_init(&buffer->num_cleared, 0);
+
+	if (capacity > 0) {
+		buffer->events = malloc(sizeof(trace_event_t) * capacity);
+		REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(buffer->events);
+
+		buffer->capacity = capacity;
+	}
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+trace_buffer_destroy(trace_buffer_t* buffer)
+{
+	ASSERT_PARAMETER(buffer);
+
+	free(buffer->events);
+	buffer->events = NULL;
+	buffer->capacity = 0;
+}
+
+bool
+trace_buffer_is_enabled(const trace_buffer_t* buffer)
+{
+	ASSERT_PARAMETER(buffer);
+
+	return buffer->capacity > 0;
+}
+
+void
+trace_buffer_record(trace_buffer_t* buffer, const trace_event_t* event)
+{
+	ASSERT_PARAMETER(buffer);
+	ASSERT_PARAMETER(event);
+
+	uint64_t index = atomic_load_explicit(&buffer->num_recorded,
+		memory_order_relaxed);
+
+	buffer->events[index % buffer->capacity] = *event;
+
+	// Publishes the event to the readers.
+	atomic_store_explicit(&buffer->num_recorded, index + 1,
+		memory_order_release);
+}
+
+void
+trace_buffer_clear(trace_buffer_t* buffer)
+{
+	ASSERT_PARAMETER(buffer);
+
+	atomic_store(&buffer->num_cleared, atomic_load(&buffer->num_recorded));
+}
+
+// Write a string as a JSON string literal.
+void
+prv_trace_write_json_string(FILE* stream, const char* string)
+{
+	fputc('"', stream);
+
+	for (const char* c = string; *c; ++c) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', stream);
+			fputc(*c, stream);
+		} else if ((unsigned char)*c < 0x20) {
+			fprintf(stream, "\\u%04x", (unsigned char)*c);
+		} else {
+			fputc(*c, stream);
+		}
+	}
+
+	fputc('"', stream);
+}
+
+// Microseconds, the unit of Chrome trace timestamps.
+double
+prv_trace_us(uint64_t ns)
+{
+	return (double)ns / 1000.0;
+}
+
+void
+trace_buffer_write_chrome(trace_buffer_t* buffer, uint64_t tid,
+	uint64_t epoch_ns, FILE* stream, bool* is_first)
+{
+	ASSERT_PARAMETER(buffer);
+	ASSERT_PARAMETER(stream);
+	ASSERT_PARAMETER(is_first);
+
+	if (!trace_buffer_is_enabled(buffer)) {
+		return;
+	}
+
+	uint64_t end
+		= atomic_load_explicit(&buffer->num_recorded, memory_order_acquire);
+	uint64_t begin = atomic_load(&buffer->num_cleared);
+
+	if (end - begin > buffer->capacity) {
+		begin = end - buffer->capacity;
+	}
+
+	for (uint64_t i = begin; i < end; ++i) {
+		const trace_event_t* event = buffer->events + i % buffer->capacity;
+
+		// Tasks made ready before tracing saw them have no queue time.
+		uint64_t wait_ns = 0;
+		if (event->ready_ns > 0 && event->ready_ns < event->start_ns) {
+			wait_ns = event->start_ns - event->ready_ns;
+		}
+
+		fputs(*is_first ? "\n" : ",\n", stream);
+		*is_first = false;
+
+		fputs("{\"name\":", stream);
+		prv_trace_write_json_string(stream, event->id ? event->id : "task");
+		fprintf(stream,
+			",\"cat\":\"task\",\"ph\":\"X\",\"pid\":0,\"tid\":%llu"
+			",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"task\":\"%p\"",
+			(unsigned long long)tid,
+			prv_trace_us(event->start_ns - epoch_ns),
+			prv_trace_us(event->end_ns - event->start_ns), event->task);
+
+		if (event->parent) {
+			fprintf(stream, ",\"parent\":\"%p\"", event->parent);
+		} else {
+			fputs(",\"parent\":null", stream);
+		}
+
+		fprintf(stream, ",\"queue_wait_us\":%.3f}}", prv_trace_us(wait_ns));
+	}
+}
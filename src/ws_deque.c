@@ -0,0 +1,178 @@
+#include "utility/ws_deque.h"
+
+#include "stdlib.h"
+#include "utility/return_macro.h"
+
+ws_deque_buffer_t*
+prv_ws_deque_buffer_create(uint64_t capacity)
+{
+	ws_deque_buffer_t* buffer
+		= malloc(sizeof *buffer + sizeof(_Atomic(void*)) * capacity);
+
+	if (!buffer) {
+		return NULL;
+	}
+
+	buffer->capacity = capacity;
+	buffer->retired = NULL;
+
+	return buffer;
+}
+
+daggle_error_code_t
+ws_deque_init(uint64_t capacity, ws_deque_t* deque)
+{
+	ASSERT_OUTPUT_PARAMETER(deque);
+
+	// Round the capacity up to a power of two, so indices can be masked.
+	uint64_t rounded = 1;
+	while (rounded < capacity) {
+		rounded <<= 1;
+	}
+
+	ws_deque_buffer_t* buffer = prv_ws_deque_buffer_create(rounded);
+	REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(buffer);
+
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->buffer, buffer);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void
+ws_deque_destroy(ws_deque_t* deque)
+{
+	ASSERT_PARAMETER(deque);
+
+	ws_deque_buffer_t* buffer = atomic_load(&deque->buffer);
+	while (buffer) {
+		ws_deque_buffer_t* retired = buffer->retired;
+		free(buffer);
+		buffer = retired;
+	}
+
+	atomic_store(&deque->buffer, NULL);
+}
+
+// Double the buffer capacity. Only the owner may call this.
+ws_deque_buffer_t*
+prv_ws_deque_grow(ws_deque_t* deque, ws_deque_buffer_t* buffer, int64_t top,
+	int64_t bottom)
+{
+	ws_deque_buffer_t* grown = prv_ws_deque_buffer_create(buffer->capacity * 2);
+	if (!grown) {
+		return NULL;
+	}
+
+	for (int64_t i = top; i < bottom; ++i) {
+		void* item = atomic_load_explicit(
+			&buffer->items[i & (buffer->capacity - 1)], memory_order_relaxed);
+		atomic_store_explicit(&grown->items[i & (grown->capacity - 1)], item,
+			memory_order_relaxed);
+	}
+
+	// Thieves may still be reading the old buffer, retire instead of free.
+	grown->retired = buffer;
+	atomic_store_explicit(&deque->buffer, grown, memory_order_release);
+
+	return grown;
+}
+
+daggle_error_code_t
+ws_deque_push(ws_deque_t* deque, void* item)
+{
+	ASSERT_PARAMETER(deque);
+
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	ws_deque_buffer_t* buffer
+		= atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+
+	if (bottom - top > (int64_t)buffer->capacity - 1) {
+		buffer = prv_ws_deque_grow(deque, buffer, top, bottom);
+		REQUIRE_ALLOCATION_DAGGLE_SUCCESSFUL(buffer);
+	}
+
+	atomic_store_explicit(&buffer->items[bottom & (buffer->capacity - 1)], item,
+		memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+
+	RETURN_STATUS(DAGGLE_SUCCESS);
+}
+
+void*
+ws_deque_pop(ws_deque_t* deque)
+{
+	ASSERT_PARAMETER(deque);
+
+	int64_t bottom
+		= atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	ws_deque_buffer_t* buffer
+		= atomic_load_explicit(&deque->buffer, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (top > bottom) {
+		// The deque was empty, restore the bottom.
+		atomic_store_explicit(&deque->bottom, bottom + 1,
+			memory_order_relaxed);
+		return NULL;
+	}
+
+	void* item = atomic_load_explicit(
+		&buffer->items[bottom & (buffer->capacity - 1)], memory_order_relaxed);
+
+	if (top == bottom) {
+		// Last item, race against thieves for it.
+		if (!atomic_compare_exchange_strong_explicit(&deque->top, &top,
+				top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+			item = NULL;
+		}
+
+		atomic_store_explicit(&deque->bottom, bottom + 1,
+			memory_order_relaxed);
+	}
+
+	return item;
+}
+
+void*
+ws_deque_steal(ws_deque_t* deque)
+{
+	ASSERT_PARAMETER(deque);
+
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (top >= bottom) {
+		return NULL;
+	}
+
+	// Consume ordering is promoted to acquire by every current compiler.
+	ws_deque_buffer_t* buffer
+		= atomic_load_explicit(&deque->buffer, memory_order_acquire);
+	void* item = atomic_load_explicit(
+		&buffer->items[top & (buffer->capacity - 1)], memory_order_relaxed);
+
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+			memory_order_seq_cst, memory_order_relaxed)) {
+		// Lost the race, the caller may retry.
+		return NULL;
+	}
+
+	return item;
+}
+
+int64_t
+ws_deque_size(ws_deque_t* deque)
+{
+	ASSERT_PARAMETER(deque);
+
+	int64_t bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	int64_t top = atomic_load_explicit(&deque->top, memory_order_acquire);
+
+	return bottom > top ? bottom - top : 0;
+}